@@ -0,0 +1,291 @@
+// Neutron - Gwennaël Arbona
+
+#include "NeutronAssetCatalogCommandlet.h"
+#include "NeutronAssetManager.h"
+
+#include "Neutron/Neutron.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/UObjectHash.h"
+
+/*----------------------------------------------------
+    Constructor
+----------------------------------------------------*/
+
+UNeutronAssetCatalogCommandlet::UNeutronAssetCatalogCommandlet() : Super()
+{
+	IsClient     = false;
+	IsEditor     = true;
+	IsServer     = false;
+	LogToConsole = true;
+}
+
+/*----------------------------------------------------
+    Commandlet interface
+----------------------------------------------------*/
+
+int32 UNeutronAssetCatalogCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("NeutronAssetCatalog.json");
+	int32   TopCount   = 20;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Top="), TopCount);
+
+	// Find descriptions the same way the asset manager does
+	TArray<FAssetData> AssetList;
+	UNeutronAssetManager::FindCatalogAssets(AssetList);
+	NLOG("UNeutronAssetCatalogCommandlet::Main : checking %d descriptions", AssetList.Num());
+
+	TArray<FNeutronAssetCatalogReportEntry> Entries;
+	TMap<FGuid, TArray<FString>>            AssetsByIdentifier;
+	TMap<FString, TArray<FString>>          DefaultsByClass;
+	TArray<FString>                         ZeroIdentifiers;
+	TArray<FString>                         StaleIdentifierTags;
+	TArray<FString>                         FailedLoads;
+	TMap<FName, int32>                      PackageUsers;
+
+	for (const FAssetData& AssetData : AssetList)
+	{
+		const FString                   Path  = AssetData.GetSoftObjectPath().ToString();
+		const UNeutronAssetDescription* Asset = Cast<UNeutronAssetDescription>(AssetData.GetAsset());
+		if (Asset == nullptr)
+		{
+			NERR("UNeutronAssetCatalogCommandlet::Main : failed to load %s", *Path);
+			FailedLoads.Add(Path);
+			continue;
+		}
+
+		// Check identifiers, and whether the registry tag the catalog is built from is up to date
+		FGuid TagIdentifier;
+		if (!Asset->Identifier.IsValid())
+		{
+			ZeroIdentifiers.Add(Path);
+		}
+		else
+		{
+			AssetsByIdentifier.FindOrAdd(Asset->Identifier).Add(Path);
+		}
+		if (!UNeutronAssetManager::GetCatalogIdentifier(AssetData, TagIdentifier) || TagIdentifier != Asset->Identifier)
+		{
+			StaleIdentifierTags.Add(Path);
+		}
+
+		// Default assets are registered by exact class
+		if (Asset->Default)
+		{
+			DefaultsByClass.FindOrAdd(Asset->GetClass()->GetPathName()).Add(Path);
+		}
+
+		// Measure everything loaded with the description
+		TSet<FName> Dependencies;
+		GetHardDependencies(AssetData.PackageName, Dependencies);
+
+		FNeutronAssetCatalogReportEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.Path                             = Path;
+		Entry.ClassName                        = Asset->GetClass()->GetName();
+		Entry.Identifier                       = Asset->Identifier;
+		Entry.HardReferenceSize                = 0;
+		Entry.HardReferenceCount               = Dependencies.Num();
+		for (FName Package : Dependencies)
+		{
+			Entry.HardReferenceSize += GetPackageSize(Package);
+			PackageUsers.FindOrAdd(Package)++;
+		}
+	}
+
+	Entries.Sort(
+		[](const FNeutronAssetCatalogReportEntry& A, const FNeutronAssetCatalogReportEntry& B)
+		{
+			return A.HardReferenceSize > B.HardReferenceSize;
+		});
+
+	auto MakeStringArray = [](const TArray<FString>& Strings)
+	{
+		TArray<TSharedPtr<FJsonValue>> Values;
+		for (const FString& String : Strings)
+		{
+			Values.Add(MakeShared<FJsonValueString>(String));
+		}
+		return Values;
+	};
+
+	int32                          ErrorCount = 0;
+	TSharedRef<FJsonObject>        Report     = MakeShared<FJsonObject>();
+	TArray<TSharedPtr<FJsonValue>> Values;
+
+	// Identifier conflicts
+	for (const auto& Identifier : AssetsByIdentifier)
+	{
+		if (Identifier.Value.Num() > 1)
+		{
+			NERR("UNeutronAssetCatalogCommandlet::Main : identifier %s is used by %d descriptions", *Identifier.Key.ToString(),
+				Identifier.Value.Num());
+
+			TSharedPtr<FJsonObject> Conflict = MakeShared<FJsonObject>();
+			Conflict->SetStringField("identifier", Identifier.Key.ToString());
+			Conflict->SetArrayField("assets", MakeStringArray(Identifier.Value));
+			Values.Add(MakeShared<FJsonValueObject>(Conflict));
+		}
+	}
+	Report->SetArrayField("duplicateIdentifiers", Values);
+	ErrorCount += Values.Num();
+	Values.Empty();
+
+	for (const FString& Path : ZeroIdentifiers)
+	{
+		NERR("UNeutronAssetCatalogCommandlet::Main : %s has no identifier", *Path);
+	}
+	Report->SetArrayField("zeroIdentifiers", MakeStringArray(ZeroIdentifiers));
+	ErrorCount += ZeroIdentifiers.Num();
+
+	// Default conflicts
+	for (const auto& Class : DefaultsByClass)
+	{
+		if (Class.Value.Num() > 1)
+		{
+			NERR("UNeutronAssetCatalogCommandlet::Main : %s has %d default descriptions", *Class.Key, Class.Value.Num());
+
+			TSharedPtr<FJsonObject> Conflict = MakeShared<FJsonObject>();
+			Conflict->SetStringField("class", Class.Key);
+			Conflict->SetArrayField("assets", MakeStringArray(Class.Value));
+			Values.Add(MakeShared<FJsonValueObject>(Conflict));
+		}
+	}
+	Report->SetArrayField("multipleDefaults", Values);
+	ErrorCount += Values.Num();
+	Values.Empty();
+
+	Report->SetArrayField("failedLoads", MakeStringArray(FailedLoads));
+	ErrorCount += FailedLoads.Num();
+
+	// Stale tags only slow catalog loading down, so they are reported without failing
+	Report->SetArrayField("staleIdentifierTags", MakeStringArray(StaleIdentifierTags));
+
+	// Descriptions, largest first
+	for (const FNeutronAssetCatalogReportEntry& Entry : Entries)
+	{
+		TSharedPtr<FJsonObject> Description = MakeShared<FJsonObject>();
+		Description->SetStringField("path", Entry.Path);
+		Description->SetStringField("class", Entry.ClassName);
+		Description->SetStringField("identifier", Entry.Identifier.ToString());
+		Description->SetNumberField("hardReferenceBytes", Entry.HardReferenceSize);
+		Description->SetNumberField("hardReferencePackages", Entry.HardReferenceCount);
+		Values.Add(MakeShared<FJsonValueObject>(Description));
+	}
+	Report->SetArrayField("descriptions", Values);
+	Values.Empty();
+
+	for (int32 Index = 0; Index < FMath::Min(TopCount, Entries.Num()); Index++)
+	{
+		NLOG("UNeutronAssetCatalogCommandlet::Main : %s loads %lld bytes in %d packages", *Entries[Index].Path,
+			Entries[Index].HardReferenceSize, Entries[Index].HardReferenceCount);
+	}
+
+	// The catalog loads all descriptions at startup, so shared packages only count once
+	TArray<FName> Packages;
+	int64         StartupSize = 0;
+	PackageUsers.GetKeys(Packages);
+	for (FName Package : Packages)
+	{
+		StartupSize += GetPackageSize(Package);
+	}
+	Packages.Sort(
+		[this](const FName& A, const FName& B)
+		{
+			return PackageSizes.FindRef(A) > PackageSizes.FindRef(B);
+		});
+	for (int32 Index = 0; Index < FMath::Min(TopCount, Packages.Num()); Index++)
+	{
+		TSharedPtr<FJsonObject> Package = MakeShared<FJsonObject>();
+		Package->SetStringField("package", Packages[Index].ToString());
+		Package->SetNumberField("bytes", PackageSizes.FindRef(Packages[Index]));
+		Package->SetNumberField("descriptions", PackageUsers.FindRef(Packages[Index]));
+		Values.Add(MakeShared<FJsonValueObject>(Package));
+	}
+	Report->SetArrayField("largestPackages", Values);
+	Report->SetNumberField("startupBytes", StartupSize);
+	Report->SetNumberField("errors", ErrorCount);
+
+	// Write the report
+	FString SerializedReport;
+	auto    JsonWriter = TJsonWriterFactory<>::Create(&SerializedReport);
+	if (!FJsonSerializer::Serialize(Report, JsonWriter) || !FFileHelper::SaveStringToFile(SerializedReport, *OutputPath))
+	{
+		NERR("UNeutronAssetCatalogCommandlet::Main : failed to write %s", *OutputPath);
+		return 1;
+	}
+
+	NLOG("UNeutronAssetCatalogCommandlet::Main : %d descriptions, %lld startup bytes, %d errors, report written to %s", Entries.Num(),
+		StartupSize, ErrorCount, *OutputPath);
+
+	return ErrorCount > 0 ? 1 : 0;
+}
+
+/*----------------------------------------------------
+    Internals
+----------------------------------------------------*/
+
+void UNeutronAssetCatalogCommandlet::GetHardDependencies(FName PackageName, TSet<FName>& Dependencies) const
+{
+	IAssetRegistry& Registry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	TArray<FName> PendingPackages;
+	PendingPackages.Add(PackageName);
+	Dependencies.Add(PackageName);
+
+	while (PendingPackages.Num())
+	{
+		TArray<FName> PackageDependencies;
+		Registry.GetDependencies(PendingPackages.Pop(), PackageDependencies, UE::AssetRegistry::EDependencyCategory::Package,
+			UE::AssetRegistry::EDependencyQuery::Hard);
+
+		for (FName Dependency : PackageDependencies)
+		{
+			// Native classes are always loaded
+			if (FPackageName::IsScriptPackage(Dependency.ToString()))
+			{
+				continue;
+			}
+
+			bool AlreadyFound = false;
+			Dependencies.Add(Dependency, &AlreadyFound);
+			if (!AlreadyFound)
+			{
+				PendingPackages.Add(Dependency);
+			}
+		}
+	}
+}
+
+int64 UNeutronAssetCatalogCommandlet::GetPackageSize(FName PackageName)
+{
+	const int64* ExistingSize = PackageSizes.Find(PackageName);
+	if (ExistingSize)
+	{
+		return *ExistingSize;
+	}
+
+	// Hard dependencies were loaded with the description, so their objects can be measured directly
+	int64     Size    = 0;
+	UPackage* Package = FindObject<UPackage>(nullptr, *PackageName.ToString());
+	if (Package)
+	{
+		ForEachObjectWithPackage(
+			Package,
+			[&Size](UObject* Object)
+			{
+				Size += Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+				return true;
+			},
+			false);
+	}
+
+	PackageSizes.Add(PackageName, Size);
+
+	return Size;
+}
@@ -0,0 +1,56 @@
+// Neutron - Gwennaël Arbona
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "NeutronAssetCatalogCommandlet.generated.h"
+
+/** Asset description as seen by the catalog report */
+struct FNeutronAssetCatalogReportEntry
+{
+	FString Path;
+	FString ClassName;
+	FGuid   Identifier;
+	int64   HardReferenceSize;
+	int32   HardReferenceCount;
+};
+
+/** Check the asset catalog for conflicts and report the memory each description loads through hard references */
+UCLASS(ClassGroup = (Neutron))
+class NEUTRON_API UNeutronAssetCatalogCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UNeutronAssetCatalogCommandlet();
+
+	/*----------------------------------------------------
+	    Commandlet interface
+	----------------------------------------------------*/
+
+	/** Write the JSON report to -Output=<path>, listing the -Top=<count> largest contributors, and fail on catalog errors */
+	virtual int32 Main(const FString& Params) override;
+
+	/*----------------------------------------------------
+	    Internals
+	----------------------------------------------------*/
+
+protected:
+
+	/** Get the transitive hard package dependencies of a package, including itself */
+	void GetHardDependencies(FName PackageName, TSet<FName>& Dependencies) const;
+
+	/** Get the estimated memory size of a loaded package */
+	int64 GetPackageSize(FName PackageName);
+
+	/*----------------------------------------------------
+	    Data
+	----------------------------------------------------*/
+
+protected:
+
+	// Package sizes already measured
+	TMap<FName, int64> PackageSizes;
+};
@@ -7,10 +7,77 @@
 
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectGlobals.h"
 
 // Statics
 UNeutronAssetManager* UNeutronAssetManager::Singleton = nullptr;
 
+// Number of asset descriptions loaded together while building the catalog
+static constexpr int32 NeutronAssetCatalogBatchSize = 64;
+
+static TAutoConsoleVariable<float> CVarNeutronAssetRetentionBudget(TEXT("Neutron.AssetRetentionBudget"), 64.0f,
+	TEXT("Memory budget in megabytes for assets kept loaded after all their handles were released"));
+
+static TAutoConsoleVariable<int32> CVarNeutronAssetMaxBackgroundLoads(TEXT("Neutron.AssetMaxBackgroundLoads"), 4,
+	TEXT("Maximum number of prefetch and background loads in flight, none of them starting while critical loads are"));
+
+static TAutoConsoleVariable<float> CVarNeutronAssetPrefetchTimeout(TEXT("Neutron.AssetPrefetchTimeout"), 10.0f,
+	TEXT("Time in seconds after which a prefetch submitted without a deadline is cancelled as stale"));
+
+/*----------------------------------------------------
+    Profiling
+----------------------------------------------------*/
+
+DECLARE_STATS_GROUP(TEXT("NeutronAssets"), STATGROUP_NeutronAssets, STATCAT_Advanced);
+
+DECLARE_MEMORY_STAT(TEXT("Resident assets"), STAT_NeutronAssets_Resident, STATGROUP_NeutronAssets);
+DECLARE_MEMORY_STAT(TEXT("Retained assets"), STAT_NeutronAssets_Retained, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Hits"), STAT_NeutronAssets_Hits, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Misses"), STAT_NeutronAssets_Misses, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Evictions"), STAT_NeutronAssets_Evictions, STATGROUP_NeutronAssets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled loads"), STAT_NeutronAssets_ScheduledLoads, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cancelled loads"), STAT_NeutronAssets_CancelledLoads, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Missed deadlines"), STAT_NeutronAssets_MissedDeadlines, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Prefetched assets"), STAT_NeutronAssets_PrefetchedAssets, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Prefetch hits"), STAT_NeutronAssets_PrefetchHits, STATGROUP_NeutronAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Prefetch misses"), STAT_NeutronAssets_PrefetchMisses, STATGROUP_NeutronAssets);
+
+/*----------------------------------------------------
+    Load scheduling
+----------------------------------------------------*/
+
+/** Get the streamable priority of a scheduled load */
+static TAsyncLoadPriority GetStreamablePriority(ENeutronAssetLoadPriority Priority)
+{
+	switch (Priority)
+	{
+		case ENeutronAssetLoadPriority::Critical:
+			return FStreamableManager::AsyncLoadHighPriority;
+		case ENeutronAssetLoadPriority::Prefetch:
+			return FStreamableManager::DefaultAsyncLoadPriority;
+		case ENeutronAssetLoadPriority::Background:
+		default:
+			return FStreamableManager::DefaultAsyncLoadPriority - FStreamableManager::AsyncLoadHighPriority;
+	}
+}
+
+/** Get the display name of a scheduled load priority */
+static const TCHAR* GetLoadPriorityName(ENeutronAssetLoadPriority Priority)
+{
+	switch (Priority)
+	{
+		case ENeutronAssetLoadPriority::Critical:
+			return TEXT("critical");
+		case ENeutronAssetLoadPriority::Prefetch:
+			return TEXT("prefetch");
+		case ENeutronAssetLoadPriority::Background:
+		default:
+			return TEXT("background");
+	}
+}
+
 /*----------------------------------------------------
     General purpose types
 ----------------------------------------------------*/
@@ -32,6 +99,148 @@ FText INeutronDescriptibleInterface::GetFormattedDescription(FString Delimiter)
 	return FText::FromString(Result);
 }
 
+/*----------------------------------------------------
+    Soft reference layouts
+----------------------------------------------------*/
+
+/** Property holding soft references in a structure, directly or through nested structures and arrays */
+struct FNeutronSoftReferenceField
+{
+	FNeutronSoftReferenceField() : Property(nullptr), Array(nullptr), SoftProperty(nullptr)
+	{}
+
+	// Property in the structure
+	const FProperty* Property;
+
+	// Property as a dynamic array, if it is one
+	const FArrayProperty* Array;
+
+	// Soft reference held by the property or its array elements, if it isn't a structure
+	const FSoftObjectProperty* SoftProperty;
+
+	// Layout of the structure held by the property or its array elements
+	TSharedPtr<const TArray<FNeutronSoftReferenceField>> Children;
+};
+
+// Layouts of structures and classes, built on first use
+static TMap<const UStruct*, TSharedPtr<TArray<FNeutronSoftReferenceField>>> NeutronSoftReferenceLayouts;
+static TSet<const UStruct*>                                                  NeutronSoftReferenceLayoutsInProgress;
+static FCriticalSection                                                      NeutronSoftReferenceLayoutsLock;
+
+/** Forget all layouts after classes were reloaded or replaced */
+static void ResetSoftReferenceLayouts()
+{
+	NeutronSoftReferenceLayoutsLock.Lock();
+	NeutronSoftReferenceLayouts.Empty();
+	NeutronSoftReferenceLayoutsLock.Unlock();
+}
+
+/** Get the fields of a structure or class holding soft references */
+static TSharedPtr<const TArray<FNeutronSoftReferenceField>> GetSoftReferenceLayout(const UStruct* Struct)
+{
+	static bool DelegatesRegistered = false;
+
+	FScopeLock Lock(&NeutronSoftReferenceLayoutsLock);
+
+	// Layouts depend on class definitions, so they are reset on hot-reload
+	if (!DelegatesRegistered)
+	{
+		FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda(
+			[](EReloadCompleteReason Reason)
+			{
+				ResetSoftReferenceLayouts();
+			});
+#if WITH_EDITOR
+		FCoreUObjectDelegates::OnObjectsReplaced.AddLambda(
+			[](const TMap<UObject*, UObject*>& ReplacedObjects)
+			{
+				ResetSoftReferenceLayouts();
+			});
+#endif    // WITH_EDITOR
+
+		DelegatesRegistered = true;
+	}
+
+	const TSharedPtr<TArray<FNeutronSoftReferenceField>>* ExistingLayout = NeutronSoftReferenceLayouts.Find(Struct);
+	if (ExistingLayout)
+	{
+		return *ExistingLayout;
+	}
+
+	// Register the layout before filling it, so that recursive structures terminate
+	TSharedPtr<TArray<FNeutronSoftReferenceField>> Layout = MakeShared<TArray<FNeutronSoftReferenceField>>();
+	NeutronSoftReferenceLayouts.Add(Struct, Layout);
+	NeutronSoftReferenceLayoutsInProgress.Add(Struct);
+
+	for (TFieldIterator<FProperty> PropIt(Struct); PropIt; ++PropIt)
+	{
+		FNeutronSoftReferenceField Field;
+		Field.Property = *PropIt;
+		Field.Array    = CastField<FArrayProperty>(*PropIt);
+
+		const FProperty* ElementProperty = Field.Array ? Field.Array->Inner : *PropIt;
+		if (const FSoftObjectProperty* SoftProperty = CastField<FSoftObjectProperty>(ElementProperty))
+		{
+			Field.SoftProperty = SoftProperty;
+			Layout->Add(Field);
+		}
+		else if (const FStructProperty* StructProperty = CastField<FStructProperty>(ElementProperty))
+		{
+			TSharedPtr<const TArray<FNeutronSoftReferenceField>> Children = GetSoftReferenceLayout(StructProperty->Struct);
+			if (Children->Num() || NeutronSoftReferenceLayoutsInProgress.Contains(StructProperty->Struct))
+			{
+				Field.Children = Children;
+				Layout->Add(Field);
+			}
+		}
+	}
+
+	NeutronSoftReferenceLayoutsInProgress.Remove(Struct);
+
+	return Layout;
+}
+
+/** Collect the soft references held by a structure or object */
+static void CollectSoftReferences(const TArray<FNeutronSoftReferenceField>& Layout, const void* Data, TSet<FSoftObjectPath>& Result)
+{
+	auto CollectElement = [&Result](const FNeutronSoftReferenceField& Field, const void* Value)
+	{
+		if (Field.SoftProperty)
+		{
+			const FSoftObjectPtr& Ptr = Field.SoftProperty->GetPropertyValue(Value);
+			if (!Ptr.IsNull())
+			{
+				Result.Add(Ptr.ToSoftObjectPath());
+			}
+		}
+		else if (Field.Children.IsValid())
+		{
+			CollectSoftReferences(*Field.Children, Value, Result);
+		}
+	};
+
+	for (const FNeutronSoftReferenceField& Field : Layout)
+	{
+		for (int32 Index = 0; Index < Field.Property->ArrayDim; Index++)
+		{
+			const void* Value = Field.Property->ContainerPtrToValuePtr<void>(Data, Index);
+
+			if (Field.Array)
+			{
+				FScriptArrayHelper ArrayHelper(Field.Array, Value);
+				for (int32 ElementIndex = 0; ElementIndex < ArrayHelper.Num(); ElementIndex++)
+				{
+					CollectElement(Field, ArrayHelper.GetRawPtr(ElementIndex));
+				}
+			}
+			else
+			{
+				CollectElement(Field, Value);
+			}
+		}
+	}
+}
+
 /*----------------------------------------------------
     Asset description
 ----------------------------------------------------*/
@@ -88,6 +297,15 @@ const UNeutronAssetDescription* UNeutronAssetDescription::LoadAsset(TSharedPtr<F
 	return Asset;
 };
 
+TArray<FSoftObjectPath> UNeutronAssetDescription::GetAsyncAssets() const
+{
+	TSet<FSoftObjectPath> Result;
+
+	CollectSoftReferences(*GetSoftReferenceLayout(GetClass()), this, Result);
+
+	return Result.Array();
+}
+
 struct FNeutronAssetPreviewSettings UNeutronAssetDescription::GetPreviewSettings() const
 {
 	return FNeutronAssetPreviewSettings();
@@ -97,7 +315,7 @@ struct FNeutronAssetPreviewSettings UNeutronAssetDescription::GetPreviewSettings
     Constructor
 ----------------------------------------------------*/
 
-UNeutronAssetManager::UNeutronAssetManager() : Super()
+UNeutronAssetManager::UNeutronAssetManager() : Super(), CatalogGeneration(0), CatalogReady(false), NextRequestIdentifier(1)
 {}
 
 /*----------------------------------------------------
@@ -108,29 +326,117 @@ void UNeutronAssetManager::Initialize(class UNeutronGameInstance* GameInstance)
 {
 	Singleton = this;
 	Catalog.Empty();
+	DefaultAssets.Empty();
+	PendingCatalog.Empty();
+	UnidentifiedAssets.Empty();
+	CatalogLoadQueue.Empty();
+	ClassIndex.Empty();
+	CatalogGeneration++;
+	CatalogReady = false;
 
+	// Get assets from the registry tags, without loading them
+	TArray<FAssetData> AssetList;
+	FindCatalogAssets(AssetList);
+	for (const FAssetData& Asset : AssetList)
+	{
+		FNeutronAssetCatalogEntry Entry;
+		Entry.Path      = Asset.GetSoftObjectPath();
+		Entry.ClassPath = Asset.AssetClassPath;
+
+		FGuid Identifier;
+		if (GetCatalogIdentifier(Asset, Identifier))
+		{
+			PendingCatalog.Add(Identifier, Entry);
+		}
+		else
+		{
+			UnidentifiedAssets.Add(Entry);
+		}
+
+		CatalogLoadQueue.Add(Entry.Path);
+	}
+
+	if (UnidentifiedAssets.Num())
+	{
+		NLOG("UNeutronAssetManager::Initialize : %d descriptions have no identifier tag and should be saved again",
+			UnidentifiedAssets.Num());
+	}
+
+	// Stream descriptions in
+	LoadNextCatalogBatch();
+}
+
+void UNeutronAssetManager::FindCatalogAssets(TArray<FAssetData>& AssetList)
+{
 	IAssetRegistry& Registry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
 
 #if WITH_EDITOR
 	Registry.SearchAllAssets(true);
 #endif
 
-	// Get assets
-	TArray<FAssetData> AssetList;
 	Registry.GetAssetsByClass(UNeutronAssetDescription::StaticClass()->GetClassPathName(), AssetList, true);
-	for (FAssetData Asset : AssetList)
+}
+
+bool UNeutronAssetManager::GetCatalogIdentifier(const FAssetData& Asset, FGuid& Identifier)
+{
+	FString IdentifierString;
+	return Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UNeutronAssetDescription, Identifier), IdentifierString) &&
+	       FGuid::Parse(IdentifierString, Identifier);
+}
+
+TArrayView<const UNeutronAssetDescription* const> UNeutronAssetManager::GetAssetsView(const UClass* AssetClass, ENeutronAssetOrder Order)
+{
+	if (!CatalogReady)
 	{
-		const UNeutronAssetDescription* Entry = Cast<UNeutronAssetDescription>(Asset.GetAsset());
-		NCHECK(Entry);
+		LoadPendingAssets(AssetClass);
+	}
 
-		Catalog.Add(TPair<FGuid, const class UNeutronAssetDescription*>(Entry->Identifier, Entry));
+	FNeutronAssetClassIndex* Index = ClassIndex.Find(AssetClass);
+	if (Index == nullptr)
+	{
+		return TArrayView<const UNeutronAssetDescription* const>();
+	}
 
-		if (Entry->Default)
+	// Sorted views are built again when assets were registered since the last sort, with identifiers breaking ties
+	if (Order == ENeutronAssetOrder::Name)
+	{
+		if (Index->AssetsByNameGeneration != Index->Generation)
+		{
+			Index->AssetsByNameGeneration = Index->Generation;
+			Index->AssetsByName           = Index->Assets;
+			Index->AssetsByName.Sort(
+				[](const UNeutronAssetDescription& A, const UNeutronAssetDescription& B)
+				{
+					const int32 NameOrder = A.Name.ToString().Compare(B.Name.ToString());
+					return NameOrder != 0 ? NameOrder < 0 : A.Identifier < B.Identifier;
+				});
+		}
+
+		return Index->AssetsByName;
+	}
+	else if (Order == ENeutronAssetOrder::Priority)
+	{
+		if (Index->AssetsByPriorityGeneration != Index->Generation)
 		{
-			DefaultAssets.Add(
-				TPair<TSubclassOf<UNeutronAssetDescription>, const class UNeutronAssetDescription*>(Entry->GetClass(), Entry));
+			Index->AssetsByPriorityGeneration = Index->Generation;
+			Index->AssetsByPriority           = Index->Assets;
+			Index->AssetsByPriority.Sort(
+				[](const UNeutronAssetDescription& A, const UNeutronAssetDescription& B)
+				{
+					if (A.Priority != B.Priority)
+					{
+						return A.Priority < B.Priority;
+					}
+
+					const int32 NameOrder = A.Name.ToString().Compare(B.Name.ToString());
+					return NameOrder != 0 ? NameOrder < 0 : A.Identifier < B.Identifier;
+				});
 		}
+
+		return Index->AssetsByPriority;
 	}
+
+	return Index->Assets;
 }
 
 void UNeutronAssetManager::LoadAsset(FSoftObjectPath Asset, FStreamableDelegate Callback)
@@ -138,11 +444,13 @@ void UNeutronAssetManager::LoadAsset(FSoftObjectPath Asset, FStreamableDelegate
 	TArray<FSoftObjectPath> Assets;
 	Assets.Add(Asset);
 
-	StreamableManager.RequestAsyncLoad(Assets, Callback);
+	ScheduleLoad(Assets, ENeutronAssetLoadPriority::Critical, 0, Callback);
 }
 
 void UNeutronAssetManager::LoadAssets(TArray<FSoftObjectPath> Assets)
 {
+	RecordPrefetchUsage(Assets);
+
 	for (FSoftObjectPath Asset : Assets)
 	{
 		StreamableManager.LoadSynchronous(Asset);
@@ -151,10 +459,841 @@ void UNeutronAssetManager::LoadAssets(TArray<FSoftObjectPath> Assets)
 
 void UNeutronAssetManager::LoadAssets(TArray<FSoftObjectPath> Assets, FStreamableDelegate Callback)
 {
-	StreamableManager.RequestAsyncLoad(Assets, Callback);
+	ScheduleLoad(Assets, ENeutronAssetLoadPriority::Critical, 0, Callback);
+}
+
+FNeutronAssetHandle UNeutronAssetManager::ScheduleLoad(
+	const TArray<FSoftObjectPath>& Assets, ENeutronAssetLoadPriority Priority, float Deadline, FStreamableDelegate Callback)
+{
+	FNeutronAssetHandle Handle;
+	Handle.Identifier = NextRequestIdentifier++;
+	if (NextRequestIdentifier == 0)
+	{
+		NextRequestIdentifier = 1;
+	}
+
+	// Prefetches always expire, so that they don't pile up behind menus that were never opened
+	if (Priority == ENeutronAssetLoadPriority::Prefetch)
+	{
+		if (Deadline <= 0)
+		{
+			Deadline = CVarNeutronAssetPrefetchTimeout.GetValueOnGameThread();
+		}
+	}
+	else
+	{
+		RecordPrefetchUsage(Assets);
+	}
+
+	FNeutronAssetLoadRequest& Request = ScheduledLoads.AddDefaulted_GetRef();
+	Request.Identifier                = Handle.Identifier;
+	Request.Assets                    = Assets;
+	Request.Priority                  = Priority;
+	Request.SubmitTime                = FPlatformTime::Seconds();
+	Request.Deadline                  = Deadline > 0 ? Request.SubmitTime + Deadline : 0;
+	Request.Callback                  = Callback;
+	Request.Started                   = false;
+	Request.DeadlineMissed            = false;
+
+	DispatchScheduledLoads();
+
+	return Handle;
+}
+
+void UNeutronAssetManager::CancelLoad(FNeutronAssetHandle& Handle)
+{
+	int32 Index = ScheduledLoads.IndexOfByPredicate(
+		[&Handle](const FNeutronAssetLoadRequest& Request)
+		{
+			return Request.Identifier == Handle.Identifier;
+		});
+
+	if (Index != INDEX_NONE)
+	{
+		TSharedPtr<FStreamableHandle> StreamableHandle = ScheduledLoads[Index].Handle;
+		ScheduledLoads.RemoveAt(Index);
+		StreamingStats.CancelledLoads++;
+		INC_DWORD_STAT(STAT_NeutronAssets_CancelledLoads);
+
+		if (StreamableHandle.IsValid())
+		{
+			StreamableHandle->CancelHandle();
+		}
+
+		DispatchScheduledLoads();
+	}
+
+	Handle.Identifier = 0;
+}
+
+void UNeutronAssetManager::PrefetchAssets(const TArray<FSoftObjectPath>& Assets)
+{
+	// Skip assets that are loaded or already prefetched
+	TArray<FSoftObjectPath> MissingAssets;
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (!Asset.IsNull() && !PrefetchedAssets.Contains(Asset) && Asset.ResolveObject() == nullptr)
+		{
+			MissingAssets.AddUnique(Asset);
+		}
+	}
+
+	if (MissingAssets.Num() == 0)
+	{
+		return;
+	}
+
+	PrefetchedAssets.Append(MissingAssets);
+	StreamingStats.PrefetchedAssets += MissingAssets.Num();
+	INC_DWORD_STAT_BY(STAT_NeutronAssets_PrefetchedAssets, MissingAssets.Num());
+
+	const uint32 Identifier = NextRequestIdentifier++;
+	if (NextRequestIdentifier == 0)
+	{
+		NextRequestIdentifier = 1;
+	}
+
+	FNeutronPrefetchRequest& Request = PrefetchRequests.AddDefaulted_GetRef();
+	Request.Identifier               = Identifier;
+	Request.Assets                   = MissingAssets;
+	Request.Expiry                   = FPlatformTime::Seconds() + CVarNeutronAssetPrefetchTimeout.GetValueOnGameThread();
+
+	FNeutronAssetHandle Load = ScheduleLoad(MissingAssets, ENeutronAssetLoadPriority::Prefetch, 0,
+		FStreamableDelegate::CreateUObject(this, &UNeutronAssetManager::OnPrefetchCompleted, Identifier));
+
+	// The load may have completed already, in which case there is nothing left to cancel
+	FNeutronPrefetchRequest* StoredRequest = PrefetchRequests.FindByPredicate(
+		[Identifier](const FNeutronPrefetchRequest& Prefetch)
+		{
+			return Prefetch.Identifier == Identifier;
+		});
+	if (StoredRequest && !StoredRequest->Handle.IsValid())
+	{
+		StoredRequest->Load = Load;
+	}
+}
+
+const FSlateBrush* UNeutronAssetManager::GetAssetRender(const UNeutronAssetDescription* Asset)
+{
+	if (Asset == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Renders are resolved synchronously by menus, each frame - loaded objects without a pending prefetch are neither hits nor misses
+	if (PrefetchedAssets.Num())
+	{
+		TArray<FSoftObjectPath> Assets;
+		Assets.Add(FSoftObjectPath(Asset));
+		if (Asset->AssetRender.GetResourceObject())
+		{
+			Assets.Add(FSoftObjectPath(Asset->AssetRender.GetResourceObject()));
+		}
+		RecordPrefetchUsage(Assets);
+	}
+
+	return &Asset->AssetRender;
+}
+
+void UNeutronAssetManager::RecordPrefetchedPanel(const TArray<FSoftObjectPath>& Assets)
+{
+	// Panels don't request their assets through the manager, so only prefetched ones can be counted
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (PrefetchedAssets.Remove(Asset) > 0)
+		{
+			StreamingStats.PrefetchHits++;
+			INC_DWORD_STAT(STAT_NeutronAssets_PrefetchHits);
+		}
+	}
 }
 
 void UNeutronAssetManager::UnloadAsset(FSoftObjectPath Asset)
 {
+	// Unloading would release the handles of other requesters too
+	if (AssetReferenceCounts.Contains(Asset))
+	{
+		NLOG("UNeutronAssetManager::UnloadAsset : %s is held through a handle", *Asset.ToString());
+		return;
+	}
+
+	// Retained assets are unloaded along with the retention handle
+	int32 RetainedIndex = RetainedAssets.IndexOfByPredicate(
+		[&Asset](const FNeutronRetainedAsset& RetainedAsset)
+		{
+			return RetainedAsset.Path == Asset;
+		});
+	if (RetainedIndex != INDEX_NONE)
+	{
+		StreamingStats.RetainedBytes -= RetainedAssets[RetainedIndex].Size;
+		StreamingStats.ResidentBytes -= RetainedAssets[RetainedIndex].Size;
+		RetainedAssets.RemoveAt(RetainedIndex);
+		UpdateStreamingStats();
+	}
+
 	StreamableManager.Unload(Asset);
 }
+
+FNeutronAssetHandle UNeutronAssetManager::AcquireAssets(
+	const TArray<FSoftObjectPath>& Assets, FName Requester, FStreamableDelegate Callback)
+{
+	FNeutronAssetHandle Handle;
+	Handle.Identifier = NextRequestIdentifier++;
+	if (NextRequestIdentifier == 0)
+	{
+		NextRequestIdentifier = 1;
+	}
+
+	FNeutronAssetRequest& Request = AssetRequests.Add(Handle.Identifier);
+	Request.Assets                = Assets;
+	Request.Requester             = Requester;
+
+	RecordPrefetchUsage(Assets);
+
+	// Reference assets
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		int32&                       ReferenceCount = AssetReferenceCounts.FindOrAdd(Asset);
+		const FNeutronRetainedAsset* RetainedAsset  = RetainedAssets.FindByPredicate(
+			[&Asset](const FNeutronRetainedAsset& Retained)
+			{
+				return Retained.Path == Asset;
+			});
+
+		// Retained assets that are held again keep their size in the resident total
+		if (RetainedAsset && ReferenceCount == 0)
+		{
+			HeldAssetSizes.Add(Asset, RetainedAsset->Size);
+			StreamingStats.RetainedBytes -= RetainedAsset->Size;
+		}
+
+		if (ReferenceCount > 0 || RetainedAsset)
+		{
+			StreamingStats.Hits++;
+		}
+		else
+		{
+			StreamingStats.Misses++;
+		}
+
+		ReferenceCount++;
+	}
+
+	// Give up retained assets that are held again, keeping their handles until the load is requested so that they stay loaded
+	TArray<TSharedPtr<FStreamableHandle>> RetainedHandles;
+	RetainedAssets.RemoveAll(
+		[this, &RetainedHandles](const FNeutronRetainedAsset& RetainedAsset)
+		{
+			if (AssetReferenceCounts.Contains(RetainedAsset.Path))
+			{
+				RetainedHandles.Add(RetainedAsset.Handle);
+				return true;
+			}
+
+			return false;
+		});
+
+	// The callback may run right away and acquire or release assets, so the request is looked up again
+	TSharedPtr<FStreamableHandle> StreamableHandle = StreamableManager.RequestAsyncLoad(
+		Assets, FStreamableDelegate::CreateUObject(this, &UNeutronAssetManager::OnAcquiredAssetsLoaded, Handle.Identifier, Callback));
+	FNeutronAssetRequest* StoredRequest = AssetRequests.Find(Handle.Identifier);
+	if (StoredRequest)
+	{
+		StoredRequest->Handle = StreamableHandle;
+	}
+	else if (StreamableHandle.IsValid())
+	{
+		StreamableHandle->ReleaseHandle();
+	}
+
+	UpdateStreamingStats();
+
+	return Handle;
+}
+
+void UNeutronAssetManager::ReleaseAssets(FNeutronAssetHandle& Handle)
+{
+	if (Handle.IsValid())
+	{
+		ReleaseRequest(Handle.Identifier);
+		Handle.Identifier = 0;
+
+		TrimRetainedAssets();
+		UpdateStreamingStats();
+	}
+}
+
+void UNeutronAssetManager::ReleaseAssets(FName Requester)
+{
+	TArray<uint32> Identifiers;
+	for (const auto& Entry : AssetRequests)
+	{
+		if (Entry.Value.Requester == Requester)
+		{
+			Identifiers.Add(Entry.Key);
+		}
+	}
+
+	for (uint32 Identifier : Identifiers)
+	{
+		ReleaseRequest(Identifier);
+	}
+
+	TrimRetainedAssets();
+	UpdateStreamingStats();
+}
+
+/*----------------------------------------------------
+    Tick
+----------------------------------------------------*/
+
+void UNeutronAssetManager::Tick(float DeltaTime)
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	// Release expired prefetches, the assets that were requested since are held by their requesters
+	TArray<FNeutronPrefetchRequest> ExpiredPrefetches;
+	for (int32 Index = PrefetchRequests.Num() - 1; Index >= 0; Index--)
+	{
+		if (CurrentTime > PrefetchRequests[Index].Expiry)
+		{
+			ExpiredPrefetches.Add(PrefetchRequests[Index]);
+			PrefetchRequests.RemoveAt(Index);
+		}
+	}
+
+	for (FNeutronPrefetchRequest& Request : ExpiredPrefetches)
+	{
+		for (const FSoftObjectPath& Asset : Request.Assets)
+		{
+			if (PrefetchedAssets.Remove(Asset) > 0)
+			{
+				StreamingStats.PrefetchMisses++;
+				INC_DWORD_STAT(STAT_NeutronAssets_PrefetchMisses);
+			}
+		}
+
+		CancelLoad(Request.Load);
+		if (Request.Handle.IsValid())
+		{
+			Request.Handle->ReleaseHandle();
+		}
+	}
+
+	if (ScheduledLoads.Num() == 0)
+	{
+		return;
+	}
+
+	// Report missed deadlines, and drop prefetches that are no longer relevant
+	TArray<TSharedPtr<FStreamableHandle>> CancelledHandles;
+	for (int32 Index = ScheduledLoads.Num() - 1; Index >= 0; Index--)
+	{
+		FNeutronAssetLoadRequest& Request = ScheduledLoads[Index];
+		if (Request.Deadline > 0 && CurrentTime > Request.Deadline && !Request.DeadlineMissed)
+		{
+			if (Request.Priority == ENeutronAssetLoadPriority::Prefetch)
+			{
+				CancelledHandles.Add(Request.Handle);
+				ScheduledLoads.RemoveAt(Index);
+				StreamingStats.CancelledLoads++;
+				INC_DWORD_STAT(STAT_NeutronAssets_CancelledLoads);
+			}
+			else
+			{
+				NERR("UNeutronAssetManager::Tick : %s load of %d assets missed its deadline, %s after %.2fs",
+					GetLoadPriorityName(Request.Priority), Request.Assets.Num(), Request.Started ? TEXT("loading") : TEXT("queued"),
+					CurrentTime - Request.SubmitTime);
+				Request.DeadlineMissed = true;
+				StreamingStats.MissedDeadlines++;
+				INC_DWORD_STAT(STAT_NeutronAssets_MissedDeadlines);
+			}
+		}
+	}
+
+	for (TSharedPtr<FStreamableHandle>& Handle : CancelledHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->CancelHandle();
+		}
+	}
+
+	if (CancelledHandles.Num())
+	{
+		DispatchScheduledLoads();
+	}
+}
+
+/*----------------------------------------------------
+    Internals
+----------------------------------------------------*/
+
+void UNeutronAssetManager::RegisterAsset(const UNeutronAssetDescription* Asset)
+{
+	const UNeutronAssetDescription* ExistingAsset = Catalog.FindRef(Asset->Identifier);
+	if (ExistingAsset == Asset)
+	{
+		return;
+	}
+
+	// Another asset with the same identifier is replaced, so it has to leave the class indexes and defaults
+	else if (ExistingAsset)
+	{
+		NERR("UNeutronAssetManager::RegisterAsset : '%s' replaces '%s' with the same identifier", *Asset->GetPathName(),
+			*ExistingAsset->GetPathName());
+
+		const UClass* Class = ExistingAsset->GetClass();
+		while (Class && Class->IsChildOf(UNeutronAssetDescription::StaticClass()))
+		{
+			FNeutronAssetClassIndex* Index = ClassIndex.Find(Class);
+			if (Index && Index->Assets.Remove(ExistingAsset) > 0)
+			{
+				Index->Generation++;
+			}
+
+			Class = Class->GetSuperClass();
+		}
+
+		if (DefaultAssets.FindRef(ExistingAsset->GetClass()) == ExistingAsset)
+		{
+			DefaultAssets.Remove(ExistingAsset->GetClass());
+		}
+	}
+
+	// Index visible assets under their class and all parent description classes
+	if (!Asset->Hidden)
+	{
+		const UClass* Class = Asset->GetClass();
+		while (Class && Class->IsChildOf(UNeutronAssetDescription::StaticClass()))
+		{
+			FNeutronAssetClassIndex& Index = ClassIndex.FindOrAdd(Class);
+			Index.Assets.Add(Asset);
+			Index.Generation++;
+
+			Class = Class->GetSuperClass();
+		}
+	}
+
+	Catalog.Add(TPair<FGuid, const class UNeutronAssetDescription*>(Asset->Identifier, Asset));
+
+	if (Asset->Default)
+	{
+		DefaultAssets.Add(TPair<TSubclassOf<UNeutronAssetDescription>, const class UNeutronAssetDescription*>(Asset->GetClass(), Asset));
+	}
+
+	// Remove the asset from the pending lists
+	PendingCatalog.Remove(Asset->Identifier);
+	if (UnidentifiedAssets.Num())
+	{
+		const FSoftObjectPath Path(Asset);
+		UnidentifiedAssets.RemoveAll(
+			[&Path](const FNeutronAssetCatalogEntry& Entry)
+			{
+				return Entry.Path == Path;
+			});
+	}
+}
+
+void UNeutronAssetManager::LoadNextCatalogBatch()
+{
+	if (CatalogLoadQueue.Num() == 0)
+	{
+		if (!CatalogReady)
+		{
+			if (PendingCatalog.Num() || UnidentifiedAssets.Num())
+			{
+				NERR("UNeutronAssetManager::LoadNextCatalogBatch : %d descriptions failed to load",
+					PendingCatalog.Num() + UnidentifiedAssets.Num());
+			}
+
+			NLOG("UNeutronAssetManager::LoadNextCatalogBatch : catalog ready with %d descriptions", Catalog.Num());
+
+			CatalogReady = true;
+			CatalogReadyDelegate.Broadcast();
+		}
+
+		return;
+	}
+
+	// Order doesn't matter, so take batches from the end of the queue
+	const int32             BatchSize = FMath::Min(NeutronAssetCatalogBatchSize, CatalogLoadQueue.Num());
+	TArray<FSoftObjectPath> Batch(CatalogLoadQueue.GetData() + CatalogLoadQueue.Num() - BatchSize, BatchSize);
+	CatalogLoadQueue.RemoveAt(CatalogLoadQueue.Num() - BatchSize, BatchSize);
+
+	StreamableManager.RequestAsyncLoad(
+		Batch, FStreamableDelegate::CreateUObject(this, &UNeutronAssetManager::OnCatalogBatchLoaded, Batch, CatalogGeneration));
+}
+
+void UNeutronAssetManager::OnCatalogBatchLoaded(TArray<FSoftObjectPath> Batch, int32 Generation)
+{
+	// Ignore batches requested before the catalog was initialized again
+	if (Generation != CatalogGeneration)
+	{
+		return;
+	}
+
+	for (const FSoftObjectPath& Path : Batch)
+	{
+		const UNeutronAssetDescription* Asset = Cast<UNeutronAssetDescription>(Path.ResolveObject());
+		if (Asset)
+		{
+			RegisterAsset(Asset);
+		}
+	}
+
+	LoadNextCatalogBatch();
+}
+
+const UNeutronAssetDescription* UNeutronAssetManager::LoadPendingAsset(FGuid Identifier)
+{
+	// The catalog is only modified on the game thread until it is ready
+	if (!IsInGameThread())
+	{
+		return nullptr;
+	}
+
+	const UNeutronAssetDescription* const* Asset = Catalog.Find(Identifier);
+	if (Asset)
+	{
+		return *Asset;
+	}
+
+	const FNeutronAssetCatalogEntry* Entry = PendingCatalog.Find(Identifier);
+	if (Entry)
+	{
+		return LoadPendingEntry(*Entry);
+	}
+
+	// Descriptions without an identifier tag could be the one, so load them in turn until it is found
+	while (UnidentifiedAssets.Num())
+	{
+		const UNeutronAssetDescription* UnidentifiedAsset = LoadPendingEntry(UnidentifiedAssets.Pop());
+		if (UnidentifiedAsset && UnidentifiedAsset->Identifier == Identifier)
+		{
+			return UnidentifiedAsset;
+		}
+	}
+
+	return nullptr;
+}
+
+void UNeutronAssetManager::LoadPendingAssets(const UClass* AssetClass)
+{
+	if (!IsInGameThread())
+	{
+		return;
+	}
+
+	// Blueprint classes may not be loaded yet, in which case the description needs to be loaded to know its class
+	auto MatchesClass = [AssetClass](const FNeutronAssetCatalogEntry& Entry)
+	{
+		const UClass* EntryClass = FindObject<UClass>(Entry.ClassPath);
+		return EntryClass == nullptr || EntryClass->IsChildOf(AssetClass);
+	};
+
+	TArray<FNeutronAssetCatalogEntry> Entries;
+	for (const auto& Entry : PendingCatalog)
+	{
+		if (MatchesClass(Entry.Value))
+		{
+			Entries.Add(Entry.Value);
+		}
+	}
+	for (const FNeutronAssetCatalogEntry& Entry : UnidentifiedAssets)
+	{
+		if (MatchesClass(Entry))
+		{
+			Entries.Add(Entry);
+		}
+	}
+
+	for (const FNeutronAssetCatalogEntry& Entry : Entries)
+	{
+		LoadPendingEntry(Entry);
+	}
+}
+
+void UNeutronAssetManager::ReleaseRequest(uint32 Identifier)
+{
+	FNeutronAssetRequest Request;
+	if (!AssetRequests.RemoveAndCopyValue(Identifier, Request))
+	{
+		return;
+	}
+
+	// Retain loaded assets that are no longer referenced, most recently released last
+	for (const FSoftObjectPath& Asset : Request.Assets)
+	{
+		int32* ReferenceCount = AssetReferenceCounts.Find(Asset);
+		if (ReferenceCount && --(*ReferenceCount) <= 0)
+		{
+			AssetReferenceCounts.Remove(Asset);
+
+			int64 Size = 0;
+			if (HeldAssetSizes.RemoveAndCopyValue(Asset, Size))
+			{
+				StreamingStats.ResidentBytes -= Size;
+			}
+
+			UObject* Object = Asset.ResolveObject();
+			if (Object)
+			{
+				FNeutronRetainedAsset& RetainedAsset = RetainedAssets.AddDefaulted_GetRef();
+				RetainedAsset.Path                   = Asset;
+				RetainedAsset.Handle                 = StreamableManager.RequestAsyncLoad(Asset);
+				RetainedAsset.Size                   = Size > 0 ? Size : Object->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+
+				StreamingStats.RetainedBytes += RetainedAsset.Size;
+				StreamingStats.ResidentBytes += RetainedAsset.Size;
+			}
+		}
+	}
+
+	if (Request.Handle.IsValid())
+	{
+		if (Request.Handle->HasLoadCompleted())
+		{
+			Request.Handle->ReleaseHandle();
+		}
+		else
+		{
+			Request.Handle->CancelHandle();
+		}
+	}
+}
+
+void UNeutronAssetManager::TrimRetainedAssets()
+{
+	const int64 Budget = static_cast<int64>(CVarNeutronAssetRetentionBudget.GetValueOnGameThread() * 1024 * 1024);
+
+	// Evict the least recently released assets first
+	int32 EvictedCount = 0;
+	while (EvictedCount < RetainedAssets.Num() && StreamingStats.RetainedBytes > Budget)
+	{
+		FNeutronRetainedAsset& RetainedAsset = RetainedAssets[EvictedCount];
+		if (RetainedAsset.Handle.IsValid())
+		{
+			RetainedAsset.Handle->ReleaseHandle();
+		}
+
+		StreamingStats.RetainedBytes -= RetainedAsset.Size;
+		StreamingStats.ResidentBytes -= RetainedAsset.Size;
+		EvictedCount++;
+	}
+
+	RetainedAssets.RemoveAt(0, EvictedCount);
+	StreamingStats.Evictions += EvictedCount;
+}
+
+void UNeutronAssetManager::OnAcquiredAssetsLoaded(uint32 Identifier, FStreamableDelegate Callback)
+{
+	// Held assets are measured once, when they are first loaded
+	const FNeutronAssetRequest* Request = AssetRequests.Find(Identifier);
+	if (Request)
+	{
+		for (const FSoftObjectPath& Asset : Request->Assets)
+		{
+			UObject* Object = Asset.ResolveObject();
+			if (Object && AssetReferenceCounts.Contains(Asset) && !HeldAssetSizes.Contains(Asset))
+			{
+				const int64 Size = Object->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				HeldAssetSizes.Add(Asset, Size);
+				StreamingStats.ResidentBytes += Size;
+			}
+		}
+
+		UpdateStreamingStats();
+	}
+
+	Callback.ExecuteIfBound();
+}
+
+void UNeutronAssetManager::UpdateStreamingStats()
+{
+	SET_MEMORY_STAT(STAT_NeutronAssets_Resident, StreamingStats.ResidentBytes);
+	SET_MEMORY_STAT(STAT_NeutronAssets_Retained, StreamingStats.RetainedBytes);
+	SET_DWORD_STAT(STAT_NeutronAssets_Hits, StreamingStats.Hits);
+	SET_DWORD_STAT(STAT_NeutronAssets_Misses, StreamingStats.Misses);
+	SET_DWORD_STAT(STAT_NeutronAssets_Evictions, StreamingStats.Evictions);
+}
+
+void UNeutronAssetManager::DispatchScheduledLoads()
+{
+	int32 CriticalLoads   = 0;
+	int32 BackgroundLoads = 0;
+	for (const FNeutronAssetLoadRequest& Request : ScheduledLoads)
+	{
+		if (Request.Started)
+		{
+			if (Request.Priority == ENeutronAssetLoadPriority::Critical)
+			{
+				CriticalLoads++;
+			}
+			else
+			{
+				BackgroundLoads++;
+			}
+		}
+	}
+
+	// Critical loads start right away, others wait for a free slot with prefetches going first
+	TArray<uint32> Identifiers;
+	for (const FNeutronAssetLoadRequest& Request : ScheduledLoads)
+	{
+		if (!Request.Started && Request.Priority == ENeutronAssetLoadPriority::Critical)
+		{
+			Identifiers.Add(Request.Identifier);
+			CriticalLoads++;
+		}
+	}
+	if (CriticalLoads == 0)
+	{
+		const int32 MaxBackgroundLoads = FMath::Max(CVarNeutronAssetMaxBackgroundLoads.GetValueOnGameThread(), 1);
+		for (ENeutronAssetLoadPriority Priority : {ENeutronAssetLoadPriority::Prefetch, ENeutronAssetLoadPriority::Background})
+		{
+			for (const FNeutronAssetLoadRequest& Request : ScheduledLoads)
+			{
+				if (!Request.Started && Request.Priority == Priority && BackgroundLoads < MaxBackgroundLoads)
+				{
+					Identifiers.Add(Request.Identifier);
+					BackgroundLoads++;
+				}
+			}
+		}
+	}
+
+	// Loads may complete while being started, so requests are looked up again each time
+	for (uint32 Identifier : Identifiers)
+	{
+		StartScheduledLoad(Identifier);
+	}
+
+	SET_DWORD_STAT(STAT_NeutronAssets_ScheduledLoads, ScheduledLoads.Num());
+}
+
+void UNeutronAssetManager::StartScheduledLoad(uint32 Identifier)
+{
+	auto FindRequest = [this, Identifier]()
+	{
+		return ScheduledLoads.FindByPredicate(
+			[Identifier](const FNeutronAssetLoadRequest& Request)
+			{
+				return Request.Identifier == Identifier;
+			});
+	};
+
+	FNeutronAssetLoadRequest* Request = FindRequest();
+	if (Request == nullptr || Request->Started)
+	{
+		return;
+	}
+	Request->Started = true;
+
+	TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(Request->Assets,
+		FStreamableDelegate::CreateUObject(this, &UNeutronAssetManager::OnScheduledLoadCompleted, Identifier),
+		GetStreamablePriority(Request->Priority));
+
+	// Empty requests don't get a handle and are complete right away
+	Request = FindRequest();
+	if (Request)
+	{
+		Request->Handle = Handle;
+		if (!Handle.IsValid())
+		{
+			OnScheduledLoadCompleted(Identifier);
+		}
+	}
+}
+
+void UNeutronAssetManager::OnScheduledLoadCompleted(uint32 Identifier)
+{
+	int32 Index = ScheduledLoads.IndexOfByPredicate(
+		[Identifier](const FNeutronAssetLoadRequest& Request)
+		{
+			return Request.Identifier == Identifier;
+		});
+
+	if (Index != INDEX_NONE)
+	{
+		FNeutronAssetLoadRequest Request = ScheduledLoads[Index];
+		ScheduledLoads.RemoveAt(Index);
+		StreamingStats.CompletedLoads++;
+
+		// Deadlines are usually caught by the tick, but loads can complete in between
+		const double CurrentTime = FPlatformTime::Seconds();
+		if (Request.Deadline > 0 && CurrentTime > Request.Deadline && !Request.DeadlineMissed)
+		{
+			NERR("UNeutronAssetManager::OnScheduledLoadCompleted : %s load of %d assets completed %.2fs after its deadline",
+				GetLoadPriorityName(Request.Priority), Request.Assets.Num(), CurrentTime - Request.Deadline);
+			StreamingStats.MissedDeadlines++;
+			INC_DWORD_STAT(STAT_NeutronAssets_MissedDeadlines);
+		}
+
+		Request.Callback.ExecuteIfBound();
+
+		DispatchScheduledLoads();
+	}
+}
+
+void UNeutronAssetManager::OnPrefetchCompleted(uint32 Identifier)
+{
+	FNeutronPrefetchRequest* Request = PrefetchRequests.FindByPredicate(
+		[Identifier](const FNeutronPrefetchRequest& Prefetch)
+		{
+			return Prefetch.Identifier == Identifier;
+		});
+
+	// Scheduled loads don't hold their assets once complete, so get a handle to keep them until the prefetch expires
+	if (Request)
+	{
+		Request->Load.Identifier = 0;
+		Request->Handle          = StreamableManager.RequestAsyncLoad(Request->Assets);
+	}
+}
+
+void UNeutronAssetManager::RecordPrefetchUsage(const TArray<FSoftObjectPath>& Assets)
+{
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (PrefetchedAssets.Num() && PrefetchedAssets.Remove(Asset) > 0)
+		{
+			StreamingStats.PrefetchHits++;
+			INC_DWORD_STAT(STAT_NeutronAssets_PrefetchHits);
+		}
+		else if (!Asset.IsNull() && Asset.ResolveObject() == nullptr)
+		{
+			StreamingStats.PrefetchMisses++;
+			INC_DWORD_STAT(STAT_NeutronAssets_PrefetchMisses);
+		}
+	}
+}
+
+const UNeutronAssetDescription* UNeutronAssetManager::LoadPendingEntry(FNeutronAssetCatalogEntry Entry)
+{
+	const UNeutronAssetDescription* Asset = Cast<UNeutronAssetDescription>(Entry.Path.TryLoad());
+	if (Asset)
+	{
+		RegisterAsset(Asset);
+	}
+	else
+	{
+		NERR("UNeutronAssetManager::LoadPendingEntry : failed to load %s", *Entry.Path.ToString());
+
+		// Don't try again
+		for (auto Iterator = PendingCatalog.CreateIterator(); Iterator; ++Iterator)
+		{
+			if (Iterator->Value.Path == Entry.Path)
+			{
+				Iterator.RemoveCurrent();
+			}
+		}
+		UnidentifiedAssets.RemoveAll(
+			[&Entry](const FNeutronAssetCatalogEntry& UnidentifiedEntry)
+			{
+				return UnidentifiedEntry.Path == Entry.Path;
+			});
+	}
+
+	return Asset;
+}
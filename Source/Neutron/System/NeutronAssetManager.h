@@ -3,6 +3,8 @@
 #pragma once
 
 #include "EngineMinimal.h"
+#include "Tickable.h"
+#include "HAL/ThreadSafeBool.h"
 #include "Engine/DataAsset.h"
 #include "Engine/StreamableManager.h"
 #include "NeutronAssetManager.generated.h"
@@ -64,23 +66,8 @@ public:
 		return Cast<T>(LoadAsset(Save, AssetName));
 	}
 
-	/** Get a list of assets to load before use*/
-	virtual TArray<FSoftObjectPath> GetAsyncAssets() const
-	{
-		TArray<FSoftObjectPath> Result;
-
-		for (TFieldIterator<FSoftObjectProperty> PropIt(GetClass()); PropIt; ++PropIt)
-		{
-			FSoftObjectProperty* Property = *PropIt;
-			FSoftObjectPtr       Ptr      = Property->GetPropertyValue(Property->ContainerPtrToValuePtr<int32>(this));
-			if (!Ptr.IsNull())
-			{
-				Result.AddUnique(Ptr.ToSoftObjectPath());
-			}
-		}
-
-		return Result;
-	}
+	/** Get a list of assets to load before use, including soft references in structures and arrays */
+	virtual TArray<FSoftObjectPath> GetAsyncAssets() const;
 
 	/** Get the desired display settings when taking shots of this asset */
 	virtual struct FNeutronAssetPreviewSettings GetPreviewSettings() const;
@@ -91,8 +78,8 @@ public:
 
 public:
 
-	// Identifier
-	UPROPERTY(Category = Neutron, EditDefaultsOnly)
+	// Identifier, searchable so that the catalog can be built without loading descriptions
+	UPROPERTY(Category = Neutron, EditDefaultsOnly, AssetRegistrySearchable)
 	FGuid Identifier;
 
 	// Display name
@@ -107,6 +94,10 @@ public:
 	UPROPERTY(Category = Neutron, EditDefaultsOnly)
 	bool Default;
 
+	// Order of this asset in sorted lists, lowest first
+	UPROPERTY(Category = Neutron, EditDefaultsOnly)
+	int32 Priority = 0;
+
 	// Generated texture file
 	UPROPERTY()
 	FSlateBrush AssetRender;
@@ -116,9 +107,160 @@ public:
     Asset manager
 ----------------------------------------------------*/
 
+/** Asset list orders */
+enum class ENeutronAssetOrder : uint8
+{
+	Registration,
+	Name,
+	Priority
+};
+
+/** Visible assets of a class and its subclasses, with sorted views built on first use */
+struct FNeutronAssetClassIndex
+{
+	FNeutronAssetClassIndex() : Generation(0), AssetsByNameGeneration(INDEX_NONE), AssetsByPriorityGeneration(INDEX_NONE)
+	{}
+
+	TArray<const class UNeutronAssetDescription*> Assets;
+	TArray<const class UNeutronAssetDescription*> AssetsByName;
+	TArray<const class UNeutronAssetDescription*> AssetsByPriority;
+
+	// Changes to the assets, and the ones sorted views were built at
+	int32 Generation;
+	int32 AssetsByNameGeneration;
+	int32 AssetsByPriorityGeneration;
+};
+
+/** Asset description found in the asset registry but not loaded yet */
+struct FNeutronAssetCatalogEntry
+{
+	FSoftObjectPath    Path;
+	FTopLevelAssetPath ClassPath;
+};
+
+/** Handle to assets held or loaded by the asset manager */
+struct FNeutronAssetHandle
+{
+	FNeutronAssetHandle() : Identifier(0)
+	{}
+
+	bool IsValid() const
+	{
+		return Identifier != 0;
+	}
+
+	uint32 Identifier;
+};
+
+/** Assets held by a requester */
+struct FNeutronAssetRequest
+{
+	TArray<FSoftObjectPath>       Assets;
+	FName                         Requester;
+	TSharedPtr<FStreamableHandle> Handle;
+};
+
+/** Asset no longer held by any requester, kept loaded in case it is requested again */
+struct FNeutronRetainedAsset
+{
+	FSoftObjectPath               Path;
+	TSharedPtr<FStreamableHandle> Handle;
+	int64                         Size;
+};
+
+/** Scheduled load priorities, lowest first */
+enum class ENeutronAssetLoadPriority : uint8
+{
+	// Bulk loads started when nothing more urgent is loading
+	Background,
+
+	// Loads likely to be needed soon, cancelled once stale
+	Prefetch,
+
+	// Loads needed for the next menu, started immediately
+	Critical
+};
+
+/** Load batch submitted to the scheduler */
+struct FNeutronAssetLoadRequest
+{
+	uint32                        Identifier;
+	TArray<FSoftObjectPath>       Assets;
+	ENeutronAssetLoadPriority     Priority;
+	double                        SubmitTime;
+	double                        Deadline;
+	FStreamableDelegate           Callback;
+	TSharedPtr<FStreamableHandle> Handle;
+	bool                          Started;
+	bool                          DeadlineMissed;
+};
+
+/** Assets prefetched on a hint, held until they expire */
+struct FNeutronPrefetchRequest
+{
+	uint32                        Identifier;
+	FNeutronAssetHandle           Load;
+	TArray<FSoftObjectPath>       Assets;
+	double                        Expiry;
+	TSharedPtr<FStreamableHandle> Handle;
+};
+
+/** Asset streaming statistics */
+struct FNeutronAssetStreamingStats
+{
+	FNeutronAssetStreamingStats()
+		: ResidentBytes(0)
+		, RetainedBytes(0)
+		, Hits(0)
+		, Misses(0)
+		, Evictions(0)
+		, CompletedLoads(0)
+		, CancelledLoads(0)
+		, MissedDeadlines(0)
+		, PrefetchedAssets(0)
+		, PrefetchHits(0)
+		, PrefetchMisses(0)
+	{}
+
+	// Estimated size of held and retained assets
+	int64 ResidentBytes;
+
+	// Estimated size of retained assets
+	int64 RetainedBytes;
+
+	// Requested assets that were already held or retained
+	int32 Hits;
+
+	// Requested assets that had to be loaded
+	int32 Misses;
+
+	// Retained assets released to stay within the retention budget
+	int32 Evictions;
+
+	// Scheduled loads that completed
+	int32 CompletedLoads;
+
+	// Scheduled loads cancelled by their caller or because they were stale
+	int32 CancelledLoads;
+
+	// Scheduled loads that completed after their deadline
+	int32 MissedDeadlines;
+
+	// Assets prefetched on a hint
+	int32 PrefetchedAssets;
+
+	// Prefetched assets that were requested before their prefetch expired
+	int32 PrefetchHits;
+
+	// Requested assets that weren't loaded nor prefetched, and prefetched assets that expired unused
+	int32 PrefetchMisses;
+};
+
 /** Catalog of dynamic assets to load in game */
 UCLASS(ClassGroup = (Neutron))
-class NEUTRON_API UNeutronAssetManager : public UObject
+class NEUTRON_API UNeutronAssetManager
+	: public UObject
+	, public FTickableGameObject
 {
 	GENERATED_BODY()
 
@@ -139,53 +281,88 @@ public:
 	/** Initialize this class */
 	void Initialize(class UNeutronGameInstance* GameInstance);
 
-	/** Find the component with the GUID that matches Identifier */
-	const UNeutronAssetDescription* GetAsset(FGuid Identifier) const
+	/** Find all asset descriptions in the asset registry, without loading them */
+	static void FindCatalogAssets(TArray<struct FAssetData>& AssetList);
+
+	/** Get the identifier of an asset description from its asset registry tags */
+	static bool GetCatalogIdentifier(const struct FAssetData& Asset, FGuid& Identifier);
+
+	/** Check whether all asset descriptions have been loaded */
+	bool IsCatalogReady() const
 	{
-		const UNeutronAssetDescription* const* Entry = Catalog.Find(Identifier);
+		return CatalogReady;
+	}
 
+	/** Get the delegate called once all asset descriptions have been loaded */
+	FSimpleMulticastDelegate& OnCatalogReady()
+	{
+		return CatalogReadyDelegate;
+	}
+
+	/** Find the component with the GUID that matches Identifier, loading it on the game thread if the catalog isn't ready */
+	const UNeutronAssetDescription* GetAsset(FGuid Identifier)
+	{
+		if (!CatalogReady)
+		{
+			return LoadPendingAsset(Identifier);
+		}
+
+		const UNeutronAssetDescription* const* Entry = Catalog.Find(Identifier);
 		return Entry ? *Entry : nullptr;
 	}
 
 	/** Find the component with the GUID that matches Identifier */
 	template <typename T>
-	const T* GetAsset(FGuid Identifier) const
+	const T* GetAsset(FGuid Identifier)
 	{
 		return Cast<T>(GetAsset(Identifier));
 	}
 
+	/** Get all visible assets of a class and its subclasses, without allocating - the view is invalidated by catalog changes */
+	TArrayView<const UNeutronAssetDescription* const> GetAssetsView(
+		const UClass* AssetClass, ENeutronAssetOrder Order = ENeutronAssetOrder::Registration);
+
+	/** Get all visible assets of a class and its subclasses, without allocating - elements are all of class T, to get with Cast<T> */
+	template <typename T>
+	TArrayView<const UNeutronAssetDescription* const> GetAssetsView(ENeutronAssetOrder Order = ENeutronAssetOrder::Registration)
+	{
+		static_assert(TIsDerivedFrom<T, UNeutronAssetDescription>::Value, "Assets need to derive from UNeutronAssetDescription");
+
+		return GetAssetsView(T::StaticClass(), Order);
+	}
+
 	/** Find all assets of a class */
 	template <typename T>
-	TArray<const T*> GetAssets() const
+	TArray<const T*> GetAssets(ENeutronAssetOrder Order = ENeutronAssetOrder::Registration)
 	{
-		TArray<const T*> Result;
+		TArrayView<const UNeutronAssetDescription* const> View = GetAssetsView<T>(Order);
 
-		for (const auto& Entry : Catalog)
+		TArray<const T*> Result;
+		Result.Reserve(View.Num());
+		for (const UNeutronAssetDescription* Asset : View)
 		{
-			if (Entry.Value->IsA<T>() && !Entry.Value->Hidden)
-			{
-				Result.Add(Cast<T>(Entry.Value));
-			}
+			Result.Add(Cast<T>(Asset));
 		}
 
 		return Result;
 	}
 
-	/** Find all assets of a class and sort */
+	/** Find all assets of a class and sort them by name */
 	template <typename T>
-	TArray<const T*> GetSortedAssets() const
+	TArray<const T*> GetSortedAssets()
 	{
-		TArray<const T*> Result = GetAssets<T>();
-
-		Result.Sort();
-
-		return Result;
+		return GetAssets<T>(ENeutronAssetOrder::Name);
 	}
 
 	/** Find the default asset of a class */
 	template <typename T>
-	const T* GetDefaultAsset() const
+	const T* GetDefaultAsset()
 	{
+		if (!CatalogReady)
+		{
+			LoadPendingAssets(T::StaticClass());
+		}
+
 		const auto Entry = DefaultAssets.Find(T::StaticClass());
 		if (Entry)
 		{
@@ -197,22 +374,135 @@ public:
 		}
 	}
 
-	/** Load an asset asynchronously */
+	/** Load an asset asynchronously, as a critical scheduled load */
 	void LoadAsset(FSoftObjectPath Entry, FStreamableDelegate Callback);
 
 	/** Load a collection of assets synchronously */
 	void LoadAssets(TArray<FSoftObjectPath> Assets);
 
-	/** Load a collection of assets asynchronously */
+	/** Load a collection of assets asynchronously, as a critical scheduled load */
 	void LoadAssets(TArray<FSoftObjectPath> Assets, FStreamableDelegate Callback);
 
-	/** Unload an asset asynchronously */
+	/** Schedule an asynchronous load, with a deadline in seconds from now - zero for none */
+	FNeutronAssetHandle ScheduleLoad(const TArray<FSoftObjectPath>& Assets, ENeutronAssetLoadPriority Priority, float Deadline = 0,
+		FStreamableDelegate Callback = FStreamableDelegate());
+
+	/** Cancel a scheduled load that hasn't completed yet, without calling its callback */
+	void CancelLoad(FNeutronAssetHandle& Handle);
+
+	/** Hint that assets are likely to be requested soon, prefetching those that aren't loaded yet */
+	void PrefetchAssets(const TArray<FSoftObjectPath>& Assets);
+
+	/** Get the share of prefetched assets that were requested before their prefetch expired */
+	float GetPrefetchHitRate() const
+	{
+		return StreamingStats.PrefetchedAssets > 0 ? static_cast<float>(StreamingStats.PrefetchHits) / StreamingStats.PrefetchedAssets : 0;
+	}
+
+	/** Get the render of an asset for display, counting it as a prefetch hit or miss */
+	const FSlateBrush* GetAssetRender(const UNeutronAssetDescription* Asset);
+
+	/** Count the prefetched assets of a panel being shown as prefetch hits */
+	void RecordPrefetchedPanel(const TArray<FSoftObjectPath>& Assets);
+
+	/** Unload an asset asynchronously, unless it is held through a handle */
 	void UnloadAsset(FSoftObjectPath Asset);
 
+	/** Load assets asynchronously and hold them until the handle is released, tagging the request with the requester's name */
+	FNeutronAssetHandle AcquireAssets(
+		const TArray<FSoftObjectPath>& Assets, FName Requester, FStreamableDelegate Callback = FStreamableDelegate());
+
+	/** Release assets held through a handle, keeping them loaded for a while in case they are requested again */
+	void ReleaseAssets(FNeutronAssetHandle& Handle);
+
+	/** Release all assets held by a requester */
+	void ReleaseAssets(FName Requester);
+
+	/** Get asset streaming statistics */
+	const FNeutronAssetStreamingStats& GetStreamingStats() const
+	{
+		return StreamingStats;
+	}
+
+	/*----------------------------------------------------
+	    Tick
+	----------------------------------------------------*/
+
+	virtual void              Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override
+	{
+		return ETickableTickType::Always;
+	}
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UNeutronAssetManager, STATGROUP_Tickables);
+	}
+	virtual bool IsTickableWhenPaused() const
+	{
+		return true;
+	}
+	virtual bool IsTickableInEditor() const
+	{
+		return false;
+	}
+
+	/*----------------------------------------------------
+	    Internals
+	----------------------------------------------------*/
+
+protected:
+
+	/** Add a loaded description to the catalog */
+	void RegisterAsset(const UNeutronAssetDescription* Asset);
+
+	/** Start loading the next batch of descriptions, or signal that the catalog is ready */
+	void LoadNextCatalogBatch();
+
+	/** Register a batch of descriptions after they were loaded */
+	void OnCatalogBatchLoaded(TArray<FSoftObjectPath> Batch, int32 Generation);
+
+	/** Synchronously load a description that was requested before the catalog was ready */
+	const UNeutronAssetDescription* LoadPendingAsset(FGuid Identifier);
+
+	/** Synchronously load the descriptions of a class that were requested before the catalog was ready */
+	void LoadPendingAssets(const UClass* AssetClass);
+
+	/** Synchronously load a pending description */
+	const UNeutronAssetDescription* LoadPendingEntry(FNeutronAssetCatalogEntry Entry);
+
+	/** Release a request, moving assets that are no longer held to the retention pool */
+	void ReleaseRequest(uint32 Identifier);
+
+	/** Release retained assets until the retention pool fits within its budget */
+	void TrimRetainedAssets();
+
+	/** Measure held assets after their load completed, then call the requester */
+	void OnAcquiredAssetsLoaded(uint32 Identifier, FStreamableDelegate Callback);
+
+	/** Publish streaming statistics */
+	void UpdateStreamingStats();
+
+	/** Start the scheduled loads allowed to run, by priority */
+	void DispatchScheduledLoads();
+
+	/** Start a scheduled load */
+	void StartScheduledLoad(uint32 Identifier);
+
+	/** Finish a scheduled load after the streamable manager completed it */
+	void OnScheduledLoadCompleted(uint32 Identifier);
+
+	/** Hold prefetched assets after their load completed */
+	void OnPrefetchCompleted(uint32 Identifier);
+
+	/** Count requested assets that were prefetched, and those that weren't while they needed loading */
+	void RecordPrefetchUsage(const TArray<FSoftObjectPath>& Assets);
+
 	/*----------------------------------------------------
 	    Public data
 	----------------------------------------------------*/
 
+public:
+
 	// Singleton pointer
 	static UNeutronAssetManager* Singleton;
 
@@ -226,4 +516,30 @@ public:
 
 	// Asynchronous asset loader
 	FStreamableManager StreamableManager;
+
+	// Catalog loading state
+	TMap<FGuid, FNeutronAssetCatalogEntry> PendingCatalog;
+	TArray<FNeutronAssetCatalogEntry>      UnidentifiedAssets;
+	TArray<FSoftObjectPath>                CatalogLoadQueue;
+	int32                                  CatalogGeneration;
+	FThreadSafeBool                        CatalogReady;
+	FSimpleMulticastDelegate               CatalogReadyDelegate;
+
+	// Visible assets by class, including subclasses
+	TMap<const UClass*, FNeutronAssetClassIndex> ClassIndex;
+
+	// Asset handles
+	TMap<uint32, FNeutronAssetRequest> AssetRequests;
+	TMap<FSoftObjectPath, int32>       AssetReferenceCounts;
+	TMap<FSoftObjectPath, int64>       HeldAssetSizes;
+	TArray<FNeutronRetainedAsset>      RetainedAssets;
+	uint32                             NextRequestIdentifier;
+	FNeutronAssetStreamingStats        StreamingStats;
+
+	// Scheduled loads, in submission order
+	TArray<FNeutronAssetLoadRequest> ScheduledLoads;
+
+	// Prefetch hints, and the prefetched assets that weren't requested yet
+	TArray<FNeutronPrefetchRequest> PrefetchRequests;
+	TSet<FSoftObjectPath>           PrefetchedAssets;
 };
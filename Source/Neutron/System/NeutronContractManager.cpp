@@ -7,11 +7,198 @@
 #include "Neutron/Player/NeutronPlayerController.h"
 #include "Neutron/Neutron.h"
 
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
 #define LOCTEXT_NAMESPACE "UNeutronContractManager"
 
 // Statics
 UNeutronContractManager* UNeutronContractManager::Singleton = nullptr;
 
+// Progress ratio above which contracts are ticked every frame
+static constexpr float NeutronContractPriorityProgress = 0.9f;
+
+// Contract save header, written before contracts in binary saves
+static constexpr uint32 NeutronContractSaveMagic = 0x5343434E;
+
+// Contract delta stream header
+static constexpr uint32 NeutronContractDeltaMagic   = 0x444E434E;
+static constexpr uint32 NeutronContractDeltaVersion = 1;
+
+// Maximum nesting depth of binary JSON values in contract deltas and saves
+static constexpr int32 NeutronContractDeltaMaxDepth = 32;
+
+/** Operations in a contract delta */
+enum class ENeutronContractDeltaOperation : uint8
+{
+	Reset,
+	Add,
+	Remove,
+	Update,
+	Track
+};
+
+/** Operation read from a contract delta */
+struct FNeutronContractDeltaEntry
+{
+	FNeutronContractDeltaEntry() : Operation(ENeutronContractDeltaOperation::Reset), Version(0)
+	{}
+
+	ENeutronContractDeltaOperation                 Operation;
+	FGuid                                          Identifier;
+	uint32                                         Version;
+	TSharedPtr<FJsonObject>                        Data;
+	TArray<TPair<FString, TSharedPtr<FJsonValue>>> Fields;
+};
+
+static TAutoConsoleVariable<float> CVarNeutronContractTickBudget(TEXT("Neutron.ContractTickBudget"), 500.0f,
+	TEXT("Time budget in microseconds for ticking contracts each frame - zero or less ticks every contract every frame"));
+
+/*----------------------------------------------------
+    Profiling
+----------------------------------------------------*/
+
+DECLARE_STATS_GROUP(TEXT("NeutronContracts"), STATGROUP_NeutronContracts, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Tick"), STAT_NeutronContracts_Tick, STATGROUP_NeutronContracts);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Evaluated contracts"), STAT_NeutronContracts_Evaluated, STATGROUP_NeutronContracts);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Deferred contracts"), STAT_NeutronContracts_Deferred, STATGROUP_NeutronContracts);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Overrun frames"), STAT_NeutronContracts_Overruns, STATGROUP_NeutronContracts);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last tick (us)"), STAT_NeutronContracts_LastTick, STATGROUP_NeutronContracts);
+
+/*----------------------------------------------------
+    Binary JSON
+----------------------------------------------------*/
+
+/** Write a JSON value in binary form */
+static void WriteContractValue(FArchive& Archive, const TSharedPtr<FJsonValue>& Value)
+{
+	uint8 Type = static_cast<uint8>(Value.IsValid() ? Value->Type : EJson::None);
+	Archive << Type;
+
+	if (Type == static_cast<uint8>(EJson::String))
+	{
+		FString String = Value->AsString();
+		Archive << String;
+	}
+	else if (Type == static_cast<uint8>(EJson::Number))
+	{
+		double Number = Value->AsNumber();
+		Archive << Number;
+	}
+	else if (Type == static_cast<uint8>(EJson::Boolean))
+	{
+		bool Boolean = Value->AsBool();
+		Archive << Boolean;
+	}
+	else if (Type == static_cast<uint8>(EJson::Array))
+	{
+		const TArray<TSharedPtr<FJsonValue>>& Values = Value->AsArray();
+		int32                                 Count  = Values.Num();
+		Archive << Count;
+		for (const TSharedPtr<FJsonValue>& Element : Values)
+		{
+			WriteContractValue(Archive, Element);
+		}
+	}
+	else if (Type == static_cast<uint8>(EJson::Object))
+	{
+		const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+		int32                          Count  = Object->Values.Num();
+		Archive << Count;
+		for (const auto& Entry : Object->Values)
+		{
+			FString Name = Entry.Key;
+			Archive << Name;
+			WriteContractValue(Archive, Entry.Value);
+		}
+	}
+}
+
+/** Read a JSON value written by WriteContractValue, returning nullptr for removed fields or invalid data */
+static TSharedPtr<FJsonValue> ReadContractValue(FArchive& Archive, int32 Depth = 0)
+{
+	uint8 Type = 0;
+	Archive << Type;
+	if (Archive.IsError() || Depth > NeutronContractDeltaMaxDepth)
+	{
+		Archive.SetError();
+		return nullptr;
+	}
+
+	if (Type == static_cast<uint8>(EJson::Null))
+	{
+		return MakeShared<FJsonValueNull>();
+	}
+	else if (Type == static_cast<uint8>(EJson::String))
+	{
+		FString String;
+		Archive << String;
+		return MakeShared<FJsonValueString>(String);
+	}
+	else if (Type == static_cast<uint8>(EJson::Number))
+	{
+		double Number = 0;
+		Archive << Number;
+		return MakeShared<FJsonValueNumber>(Number);
+	}
+	else if (Type == static_cast<uint8>(EJson::Boolean))
+	{
+		bool Boolean = false;
+		Archive << Boolean;
+		return MakeShared<FJsonValueBoolean>(Boolean);
+	}
+	else if (Type == static_cast<uint8>(EJson::Array))
+	{
+		int32 Count = 0;
+		Archive << Count;
+		if (Count < 0 || Count > Archive.TotalSize() - Archive.Tell())
+		{
+			Archive.SetError();
+			return nullptr;
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Values;
+		for (int32 Index = 0; Index < Count && !Archive.IsError(); Index++)
+		{
+			TSharedPtr<FJsonValue> Element = ReadContractValue(Archive, Depth + 1);
+			Values.Add(Element.IsValid() ? Element : MakeShared<FJsonValueNull>());
+		}
+		return MakeShared<FJsonValueArray>(Values);
+	}
+	else if (Type == static_cast<uint8>(EJson::Object))
+	{
+		int32 Count = 0;
+		Archive << Count;
+		if (Count < 0 || Count > Archive.TotalSize() - Archive.Tell())
+		{
+			Archive.SetError();
+			return nullptr;
+		}
+
+		TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+		for (int32 Index = 0; Index < Count && !Archive.IsError(); Index++)
+		{
+			FString Name;
+			Archive << Name;
+			TSharedPtr<FJsonValue> Element = ReadContractValue(Archive, Depth + 1);
+			if (Element.IsValid())
+			{
+				Object->SetField(Name, Element);
+			}
+		}
+		return MakeShared<FJsonValueObject>(Object);
+	}
+	else if (Type != static_cast<uint8>(EJson::None))
+	{
+		Archive.SetError();
+	}
+
+	return nullptr;
+}
+
 /*----------------------------------------------------
     Base contract class
 ----------------------------------------------------*/
@@ -26,6 +213,8 @@ TSharedRef<FJsonObject> FNeutronContract::Save() const
 	TSharedRef<FJsonObject> Data = MakeShared<FJsonObject>();
 
 	Data->SetNumberField("Type", static_cast<int>(Type));
+	Data->SetStringField("Identifier", Identifier.ToString(EGuidFormats::Short));
+	Data->SetNumberField("Version", Version);
 
 	return Data;
 }
@@ -35,27 +224,136 @@ void FNeutronContract::Load(const TSharedPtr<FJsonObject>& Data)
 	NCHECK(Data.IsValid());
 
 	Type = static_cast<ENeutronContractType>(Data->GetNumberField("Type"));
+
+	// Contracts from older saves have no identifier
+	FString IdentifierString;
+	if (Data->TryGetStringField("Identifier", IdentifierString))
+	{
+		FGuid::Parse(IdentifierString, Identifier);
+	}
+
+	uint32 SavedVersion;
+	if (Data->TryGetNumberField("Version", SavedVersion))
+	{
+		Version = SavedVersion;
+	}
+}
+
+void FNeutronContract::MarkDirty(const FString& FieldName)
+{
+	Version++;
+
+	const bool WasClean = DirtyFields.Num() == 0;
+	DirtyFields.Add(FieldName);
+
+	if (WasClean && Manager.IsValid())
+	{
+		Manager->MarkContractDirty(AsShared());
+	}
 }
 
 /*----------------------------------------------------
     Constructor
 ----------------------------------------------------*/
 
-UNeutronContractManager::UNeutronContractManager() : ShouldStartTutorial(false)
+UNeutronContractManager::UNeutronContractManager()
+	: ShouldStartTutorial(false)
+	, DispatchDepth(0)
+	, HasInactiveListeners(false)
+	, TickTime(0)
+	, TickCursor(0)
+	, DeltaReset(false)
+	, TrackedContractDirty(false)
+	, ApplyingDelta(false)
 {}
 
 /*----------------------------------------------------
     Loading & saving
 ----------------------------------------------------*/
 
+bool FNeutronContractManagerSave::Serialize(FArchive& Ar)
+{
+	// Binary saves from previous versions hold tagged properties, which the engine reads when this returns false
+	int64  Start = Ar.Tell();
+	uint32 Magic = NeutronContractSaveMagic;
+	Ar << Magic;
+	if (Ar.IsLoading() && Magic != NeutronContractSaveMagic)
+	{
+		Ar.Seek(Start);
+		return false;
+	}
+
+	Ar << CurrentTrackedContract;
+
+	int32 Count = Contracts.Num();
+	Ar << Count;
+	if (Ar.IsLoading())
+	{
+		if (Count < 0 || Count > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return true;
+		}
+		Contracts.SetNum(Count);
+	}
+	ContractBlocks.SetNum(Count);
+
+	// Write each contract as its serializer block, or as its structured object in binary form
+	for (int32 Index = 0; Index < Count && !Ar.IsError(); Index++)
+	{
+		Ar << ContractBlocks[Index];
+		if (ContractBlocks[Index].Num() > 0)
+		{
+			continue;
+		}
+		else if (Ar.IsLoading())
+		{
+			TSharedPtr<FJsonValue> Value = ReadContractValue(Ar);
+			if (Value.IsValid() && Value->Type == EJson::Object)
+			{
+				Contracts[Index].JsonObject = Value->AsObject();
+			}
+		}
+		else
+		{
+			WriteContractValue(Ar, MakeShared<FJsonValueObject>(Contracts[Index].JsonObject));
+		}
+	}
+
+	return true;
+}
+
 FNeutronContractManagerSave UNeutronContractManager::Save() const
+{
+	const UNeutronSaveManager* SaveManager = UNeutronSaveManager::Get();
+
+	return Save(SaveManager ? SaveManager->GetSaveFormat() : ENeutronSaveFormat::Json);
+}
+
+FNeutronContractManagerSave UNeutronContractManager::Save(ENeutronSaveFormat Format) const
 {
 	FNeutronContractManagerSave SaveData;
 
-	// Save contracts
+	// Save contracts as structured objects for JSON saves, and as blocks for binary saves when their type has a serializer
 	for (TSharedPtr<FNeutronContract> Contract : CurrentContracts)
 	{
-		SaveData.ContractSaveData.Add(UNeutronSaveManager::JsonToString(Contract->Save()));
+		FJsonObjectWrapper& ContractData  = SaveData.Contracts.AddDefaulted_GetRef();
+		TArray<uint8>&      ContractBlock = SaveData.ContractBlocks.AddDefaulted_GetRef();
+
+		const FNeutronContractTypeInfo* TypeInfo = ContractTypes.Find(Contract->GetType());
+		if (Format == ENeutronSaveFormat::Binary && TypeInfo && TypeInfo->Serializer.IsBound())
+		{
+			FMemoryWriter Writer(ContractBlock);
+			uint8         TypeValue = static_cast<uint8>(Contract->GetType());
+			Writer << TypeValue;
+			Writer << Contract->Identifier;
+			Writer << Contract->Version;
+			TypeInfo->Serializer.Execute(*Contract, Writer);
+		}
+		else
+		{
+			ContractData.JsonObject = Contract->Save();
+		}
 	}
 
 	// Save the tracked contract
@@ -67,29 +365,51 @@ FNeutronContractManagerSave UNeutronContractManager::Save() const
 void UNeutronContractManager::Load(const FNeutronContractManagerSave& SaveData)
 {
 	// Reset the state from a potential previous session
-	CurrentContracts.Empty();
+	ResetContracts();
 	GeneratedContract.Reset();
 
-	NCHECK(ContractGenerator.IsBound());
-
 	// Load contracts
-	if (SaveData.ContractSaveData.Num())
+	if (SaveData.Contracts.Num() || SaveData.ContractSaveData.Num())
 	{
-		for (const FString& SerializedContract : SaveData.ContractSaveData)
+		for (int32 Index = 0; Index < SaveData.Contracts.Num(); Index++)
 		{
-			TSharedPtr<FJsonObject> ContractData = UNeutronSaveManager::StringToJson(SerializedContract);
+			TSharedPtr<FNeutronContract> Contract;
+			if (SaveData.ContractBlocks.IsValidIndex(Index) && SaveData.ContractBlocks[Index].Num() > 0)
+			{
+				Contract = LoadContract(SaveData.ContractBlocks[Index]);
+			}
+			else
+			{
+				// Binary saves from previous versions hold contracts as strings
+				const FJsonObjectWrapper& ContractData   = SaveData.Contracts[Index];
+				TSharedPtr<FJsonObject>   ContractObject = ContractData.JsonObject;
+				if (!ContractObject.IsValid() && !ContractData.JsonString.IsEmpty())
+				{
+					ContractObject = UNeutronSaveManager::StringToJson(ContractData.JsonString);
+				}
 
-			FNeutronContract TestContract;
-			TestContract.Load(ContractData);
+				Contract = LoadContract(ContractObject);
+			}
 
-			TSharedPtr<FNeutronContract> Contract = ContractGenerator.Execute(TestContract.GetType(), GameInstance);
-			Contract->Load(ContractData);
+			if (Contract.IsValid())
+			{
+				AddContract(Contract);
+			}
+		}
 
-			CurrentContracts.Add(Contract);
+		for (const FString& SerializedContract : SaveData.ContractSaveData)
+		{
+			TSharedPtr<FNeutronContract> Contract = LoadContract(UNeutronSaveManager::StringToJson(SerializedContract));
+			if (Contract.IsValid())
+			{
+				AddContract(Contract);
+			}
 		}
 
 		// Get the tracked contract
 		CurrentTrackedContract = SaveData.CurrentTrackedContract;
+		TrackedContractDirty   = true;
+		UpdateTickPriority();
 	}
 
 	// No contract structure was found, so it's a new game
@@ -121,19 +441,92 @@ void UNeutronContractManager::BeginPlay(ANeutronPlayerController* PC, FNeutronCo
 		NLOG("UNeutronContractManager::Load : adding tutorial contract");
 
 		// Add a tutorial contract and track it
-		TSharedPtr<FNeutronContract> Tutorial = ContractGenerator.Execute(ENeutronContractType::Tutorial, GameInstance);
-		CurrentContracts.Add(Tutorial);
+		TSharedPtr<FNeutronContract> Tutorial = CreateContract(ENeutronContractType::Tutorial);
+		AddContract(Tutorial);
 
 		ShouldStartTutorial = false;
 	}
 }
 
+void UNeutronContractManager::RegisterContractType(
+	ENeutronContractType Type, FNeutronContractFactory Factory, FNeutronContractSerializer Serializer)
+{
+	NCHECK(Factory.IsBound());
+
+	FNeutronContractTypeInfo TypeInfo;
+	TypeInfo.Factory    = Factory;
+	TypeInfo.Serializer = Serializer;
+	ContractTypes.Add(Type, TypeInfo);
+}
+
 void UNeutronContractManager::OnEvent(FNeutronContractEvent Event)
 {
-	TArray<TSharedPtr<FNeutronContract>> SafeCurrentContracts = CurrentContracts;
-	for (TSharedPtr<FNeutronContract> Contract : SafeCurrentContracts)
+	TArray<FNeutronContractListener>* EventListeners = Listeners.Find(Event.Type);
+	if (EventListeners == nullptr)
+	{
+		return;
+	}
+
+	// Listener lists are left untouched until the outermost dispatch ends, so no copy is needed
+	DispatchDepth++;
+	const int32 ListenerCount = EventListeners->Num();
+	for (int32 Index = 0; Index < ListenerCount; Index++)
+	{
+		const FNeutronContractListener& Listener = (*EventListeners)[Index];
+		if (Listener.Active && (!Listener.Filter.IsValid() || Listener.Filter == Event.Target))
+		{
+			Listener.Contract->OnEvent(Event);
+		}
+	}
+	DispatchDepth--;
+
+	if (DispatchDepth == 0)
+	{
+		FlushSubscriptions();
+	}
+}
+
+void UNeutronContractManager::Subscribe(TSharedPtr<FNeutronContract> Contract, FNeutronContractSubscription Subscription)
+{
+	NCHECK(Contract.IsValid());
+
+	if (DispatchDepth > 0)
+	{
+		PendingSubscriptions.Add(TPair<TSharedPtr<FNeutronContract>, FNeutronContractSubscription>(Contract, Subscription));
+	}
+	else
+	{
+		FNeutronContractListener Listener(Contract, Subscription.Filter, TickTime);
+		Listener.Precise  = Contract->NeedsPreciseTick();
+		Listener.Priority = IsPriorityContract(Contract.Get());
+		Listeners.FindOrAdd(Subscription.Type).Add(Listener);
+	}
+}
+
+void UNeutronContractManager::Unsubscribe(TSharedPtr<FNeutronContract> Contract)
+{
+	// Listeners are only flagged here, as the contract may be the one currently receiving an event
+	for (auto& Entry : Listeners)
 	{
-		Contract->OnEvent(Event);
+		for (FNeutronContractListener& Listener : Entry.Value)
+		{
+			if (Listener.Contract == Contract)
+			{
+				Listener.Active      = false;
+				HasInactiveListeners = true;
+			}
+		}
+	}
+
+	PendingSubscriptions.RemoveAll(
+		[&Contract](const TPair<TSharedPtr<FNeutronContract>, FNeutronContractSubscription>& Pending)
+		{
+			return Pending.Key == Contract;
+		});
+
+	if (DispatchDepth == 0)
+	{
+		FlushSubscriptions();
 	}
 }
 
@@ -145,7 +538,7 @@ FNeutronContractDetails UNeutronContractManager::GenerateNewContract(ENeutronCon
 {
 	NLOG("UNeutronContractManager::GenerateNewContract");
 
-	GeneratedContract = ContractGenerator.Execute(Type, GameInstance);
+	GeneratedContract = CreateContract(Type);
 
 	return GeneratedContract->GetDisplayDetails();
 }
@@ -154,10 +547,10 @@ void UNeutronContractManager::AcceptContract()
 {
 	NLOG("UNeutronContractManager::AcceptContract");
 
-	CurrentContracts.Add(GeneratedContract);
+	AddContract(GeneratedContract);
 	GeneratedContract.Reset();
 
-	PlayerController->Notify(LOCTEXT("ContractAccepted", "Contract accepted"), FText(), ENeutronNotificationType::Info);
+	Notify(LOCTEXT("ContractAccepted", "Contract accepted"));
 }
 
 void UNeutronContractManager::DeclineContract()
@@ -171,16 +564,18 @@ void UNeutronContractManager::ProgressContract(TSharedPtr<class FNeutronContract
 {
 	NLOG("UNeutronContractManager::ProgressContract");
 
-	PlayerController->Notify(LOCTEXT("ContractUpdated", "Contract updated"), FText(), ENeutronNotificationType::Info);
+	UpdateTickPriority(Contract.Get());
+
+	Notify(LOCTEXT("ContractUpdated", "Contract updated"));
 }
 
 void UNeutronContractManager::CompleteContract(TSharedPtr<class FNeutronContract> Contract)
 {
 	NLOG("UNeutronContractManager::CompleteContract");
 
-	CurrentContracts.Remove(Contract);
+	RemoveContract(Contract);
 
-	PlayerController->Notify(LOCTEXT("ContractComplete", "Contract complete"), FText(), ENeutronNotificationType::Info);
+	Notify(LOCTEXT("ContractComplete", "Contract complete"));
 }
 
 uint32 UNeutronContractManager::GetContractCount() const
@@ -200,14 +595,16 @@ void UNeutronContractManager::SetTrackedContract(int32 Index)
 	NLOG("UNeutronContractManager::SetTrackedContract %d", Index);
 
 	CurrentTrackedContract = Index;
+	TrackedContractDirty   = true;
+	UpdateTickPriority();
 
 	if (Index >= 0)
 	{
-		PlayerController->Notify(LOCTEXT("ContractTracked", "Contract tracked"), FText(), ENeutronNotificationType::Info);
+		Notify(LOCTEXT("ContractTracked", "Contract tracked"));
 	}
 	else
 	{
-		PlayerController->Notify(LOCTEXT("ContractUntracked", "Contract untracked"), FText(), ENeutronNotificationType::Info);
+		Notify(LOCTEXT("ContractUntracked", "Contract untracked"));
 	}
 }
 
@@ -217,13 +614,9 @@ void UNeutronContractManager::AbandonContract(int32 Index)
 
 	NCHECK(Index >= 0 && Index < CurrentContracts.Num());
 
-	CurrentContracts.RemoveAt(Index);
-	if (CurrentTrackedContract == Index)
-	{
-		CurrentTrackedContract = INDEX_NONE;
-	}
+	RemoveContract(CurrentContracts[Index]);
 
-	PlayerController->Notify(LOCTEXT("ContractAbandoned", "Contract abandoned"), FText(), ENeutronNotificationType::Info);
+	Notify(LOCTEXT("ContractAbandoned", "Contract abandoned"));
 }
 
 int32 UNeutronContractManager::GetTrackedContract()
@@ -232,12 +625,1018 @@ int32 UNeutronContractManager::GetTrackedContract()
 }
 
 /*----------------------------------------------------
-    Tick
+    Internals
 ----------------------------------------------------*/
 
-void UNeutronContractManager::Tick(float DeltaTime)
+TSharedPtr<FNeutronContract> UNeutronContractManager::CreateContract(ENeutronContractType Type)
+{
+	const FNeutronContractTypeInfo* TypeInfo = ContractTypes.Find(Type);
+	if (TypeInfo)
+	{
+		return TypeInfo->Factory.Execute(GameInstance);
+	}
+
+	NCHECK(ContractGenerator.IsBound());
+	return ContractGenerator.Execute(Type, GameInstance);
+}
+
+TSharedPtr<FNeutronContract> UNeutronContractManager::LoadContract(const TSharedPtr<FJsonObject>& ContractData)
+{
+	double TypeValue;
+	if (!ContractData.IsValid() || !ContractData->TryGetNumberField("Type", TypeValue))
+	{
+		NERR("UNeutronContractManager::LoadContract : invalid contract data");
+		return nullptr;
+	}
+
+	TSharedPtr<FNeutronContract> Contract = CreateContract(static_cast<ENeutronContractType>(TypeValue));
+	if (Contract.IsValid())
+	{
+		Contract->Load(ContractData);
+	}
+
+	return Contract;
+}
+
+TSharedPtr<FNeutronContract> UNeutronContractManager::LoadContract(const TArray<uint8>& ContractBlock)
+{
+	FMemoryReader Reader(ContractBlock);
+	uint8         TypeValue = 0;
+	Reader << TypeValue;
+
+	ENeutronContractType            Type     = static_cast<ENeutronContractType>(TypeValue);
+	const FNeutronContractTypeInfo* TypeInfo = ContractTypes.Find(Type);
+	if (Reader.IsError() || TypeInfo == nullptr || !TypeInfo->Serializer.IsBound())
+	{
+		NERR("UNeutronContractManager::LoadContract : no serializer for contract type %d", TypeValue);
+		return nullptr;
+	}
+
+	TSharedPtr<FNeutronContract> Contract = CreateContract(Type);
+	if (Contract.IsValid())
+	{
+		Contract->Type = Type;
+		Reader << Contract->Identifier;
+		Reader << Contract->Version;
+		TypeInfo->Serializer.Execute(*Contract, Reader);
+
+		if (Reader.IsError())
+		{
+			NERR("UNeutronContractManager::LoadContract : invalid block for contract type %d", TypeValue);
+			return nullptr;
+		}
+	}
+
+	return Contract;
+}
+
+void UNeutronContractManager::AddContract(TSharedPtr<FNeutronContract> Contract)
+{
+	CurrentContracts.Add(Contract);
+
+	// New contracts are sent whole with the next delta, unless they came from one
+	Contract->Manager = this;
+	Contract->DirtyFields.Empty();
+	ContractsById.Add(Contract->Identifier, Contract);
+	if (!ApplyingDelta)
+	{
+		AddedContracts.Add(Contract->Identifier);
+	}
+
+	for (const FNeutronContractSubscription& Subscription : Contract->GetSubscriptions())
+	{
+		Subscribe(Contract, Subscription);
+	}
+}
+
+void UNeutronContractManager::RemoveContract(TSharedPtr<FNeutronContract> Contract)
+{
+	Unsubscribe(Contract);
+
+	// Keep the tracked contract index pointing to the same contract
+	const int32 Index = CurrentContracts.Find(Contract);
+	if (Index != INDEX_NONE)
+	{
+		CurrentContracts.RemoveAt(Index);
+
+		if (CurrentTrackedContract == Index)
+		{
+			CurrentTrackedContract = INDEX_NONE;
+			TrackedContractDirty   = TrackedContractDirty || !ApplyingDelta;
+			UpdateTickPriority();
+		}
+		else if (CurrentTrackedContract > Index)
+		{
+			CurrentTrackedContract--;
+		}
+	}
+
+	ContractsById.Remove(Contract->Identifier);
+	if (AddedContracts.Remove(Contract->Identifier) == 0 && !ApplyingDelta)
+	{
+		RemovedContracts.Add(Contract->Identifier);
+	}
+}
+
+void UNeutronContractManager::ResetContracts()
+{
+	for (auto& Entry : Listeners)
+	{
+		for (FNeutronContractListener& Listener : Entry.Value)
+		{
+			Listener.Active = false;
+		}
+	}
+	HasInactiveListeners = true;
+
+	PendingSubscriptions.Empty();
+	CurrentContracts.Empty();
+
+	// Start the next delta from an empty contract list
+	ContractsById.Empty();
+	AddedContracts.Empty();
+	RemovedContracts.Empty();
+	DirtyContracts.Empty();
+	DeltaReset           = !ApplyingDelta;
+	TrackedContractDirty = !ApplyingDelta;
+
+	if (DispatchDepth == 0)
+	{
+		FlushSubscriptions();
+	}
+}
+
+void UNeutronContractManager::FlushSubscriptions()
+{
+	NCHECK(DispatchDepth == 0);
+
+	if (HasInactiveListeners)
+	{
+		for (auto& Entry : Listeners)
+		{
+			// Keep the tick cursor on the same listener as the ones before it are removed
+			if (Entry.Key == ENeutronContratEventType::Tick)
+			{
+				int32 RemovedBeforeCursor = 0;
+				for (int32 Index = 0; Index < FMath::Min(TickCursor, Entry.Value.Num()); Index++)
+				{
+					if (!Entry.Value[Index].Active)
+					{
+						RemovedBeforeCursor++;
+					}
+				}
+				TickCursor -= RemovedBeforeCursor;
+			}
+
+			Entry.Value.RemoveAll(
+				[](const FNeutronContractListener& Listener)
+				{
+					return !Listener.Active;
+				});
+		}
+
+		HasInactiveListeners = false;
+	}
+
+	for (const TPair<TSharedPtr<FNeutronContract>, FNeutronContractSubscription>& Pending : PendingSubscriptions)
+	{
+		FNeutronContractListener Listener(Pending.Key, Pending.Value.Filter, TickTime);
+		Listener.Precise  = Pending.Key->NeedsPreciseTick();
+		Listener.Priority = IsPriorityContract(Pending.Key.Get());
+		Listeners.FindOrAdd(Pending.Value.Type).Add(Listener);
+	}
+	PendingSubscriptions.Empty();
+}
+
+void UNeutronContractManager::MarkContractDirty(TSharedPtr<FNeutronContract> Contract)
+{
+	if (!ApplyingDelta)
+	{
+		DirtyContracts.Add(Contract);
+	}
+}
+
+void UNeutronContractManager::Notify(const FText& Text)
 {
-	OnEvent(ENeutronContratEventType::Tick);
+	if (PlayerController)
+	{
+		PlayerController->Notify(Text, FText(), ENeutronNotificationType::Info);
+	}
+}
+
+bool UNeutronContractManager::IsPriorityContract(const FNeutronContract* Contract) const
+{
+	const bool IsTracked =
+		CurrentContracts.IsValidIndex(CurrentTrackedContract) && CurrentContracts[CurrentTrackedContract].Get() == Contract;
+
+	return IsTracked || Contract->GetProgress() >= NeutronContractPriorityProgress;
+}
+
+void UNeutronContractManager::UpdateTickPriority(const FNeutronContract* Contract)
+{
+	TArray<FNeutronContractListener>* TickListeners = Listeners.Find(ENeutronContratEventType::Tick);
+	if (TickListeners)
+	{
+		for (FNeutronContractListener& Listener : *TickListeners)
+		{
+			if (Contract == nullptr || Listener.Contract.Get() == Contract)
+			{
+				Listener.Priority = IsPriorityContract(Listener.Contract.Get());
+			}
+		}
+	}
 }
 
+/*----------------------------------------------------
+    Contract deltas
+----------------------------------------------------*/
+
+bool UNeutronContractManager::BuildDelta(TArray<uint8>& Delta)
+{
+	Delta.Reset();
+
+	if (!DeltaReset && !TrackedContractDirty && AddedContracts.Num() == 0 && RemovedContracts.Num() == 0 && DirtyContracts.Num() == 0)
+	{
+		return false;
+	}
+
+	FMemoryWriter Writer(Delta);
+	uint32        Magic         = NeutronContractDeltaMagic;
+	uint32        FormatVersion = NeutronContractDeltaVersion;
+	Writer << Magic << FormatVersion;
+
+	auto WriteOperation = [&Writer](ENeutronContractDeltaOperation Operation, FGuid Identifier)
+	{
+		uint8 OperationValue = static_cast<uint8>(Operation);
+		Writer << OperationValue << Identifier;
+	};
+
+	// Start over from an empty list
+	if (DeltaReset)
+	{
+		WriteOperation(ENeutronContractDeltaOperation::Reset, FGuid());
+	}
+
+	// Removed contracts
+	for (const FGuid& Identifier : RemovedContracts)
+	{
+		WriteOperation(ENeutronContractDeltaOperation::Remove, Identifier);
+	}
+
+	// New contracts are written whole
+	for (const FGuid& Identifier : AddedContracts)
+	{
+		const TSharedPtr<FNeutronContract>* Contract = ContractsById.Find(Identifier);
+		if (Contract)
+		{
+			WriteOperation(ENeutronContractDeltaOperation::Add, Identifier);
+			WriteContractValue(Writer, MakeShared<FJsonValueObject>((*Contract)->Save()));
+		}
+	}
+
+	// Changed fields of existing contracts
+	for (const TWeakPtr<FNeutronContract>& WeakContract : DirtyContracts)
+	{
+		TSharedPtr<FNeutronContract> Contract = WeakContract.Pin();
+		if (Contract.IsValid() && Contract->DirtyFields.Num() && ContractsById.Contains(Contract->Identifier))
+		{
+			WriteOperation(ENeutronContractDeltaOperation::Update, Contract->Identifier);
+
+			TSharedRef<FJsonObject> Data       = Contract->Save();
+			uint32                  Version    = Contract->Version;
+			int32                   FieldCount = Contract->DirtyFields.Num();
+			Writer << Version << FieldCount;
+			for (FString FieldName : Contract->DirtyFields)
+			{
+				Writer << FieldName;
+				WriteContractValue(Writer, Data->TryGetField(FieldName));
+			}
+		}
+
+	}
+
+	// Tracked contract
+	if (TrackedContractDirty)
+	{
+		FGuid TrackedIdentifier;
+		if (CurrentContracts.IsValidIndex(CurrentTrackedContract))
+		{
+			TrackedIdentifier = CurrentContracts[CurrentTrackedContract]->Identifier;
+		}
+		WriteOperation(ENeutronContractDeltaOperation::Track, TrackedIdentifier);
+	}
+
+	ClearDelta();
+
+	return true;
+}
+
+void UNeutronContractManager::ClearDelta()
+{
+	for (const TWeakPtr<FNeutronContract>& WeakContract : DirtyContracts)
+	{
+		TSharedPtr<FNeutronContract> Contract = WeakContract.Pin();
+		if (Contract.IsValid())
+		{
+			Contract->DirtyFields.Empty();
+		}
+	}
+
+	DeltaReset           = false;
+	TrackedContractDirty = false;
+	AddedContracts.Empty();
+	RemovedContracts.Empty();
+	DirtyContracts.Empty();
+}
+
+bool UNeutronContractManager::ApplyDelta(const TArray<uint8>& Delta)
+{
+	FMemoryReader Reader(Delta);
+	uint32        Magic         = 0;
+	uint32        FormatVersion = 0;
+	Reader << Magic << FormatVersion;
+	if (Reader.IsError() || Magic != NeutronContractDeltaMagic || FormatVersion > NeutronContractDeltaVersion)
+	{
+		NERR("UNeutronContractManager::ApplyDelta : invalid delta header");
+		return false;
+	}
+
+	// Read the whole delta first, so that a corrupted one leaves contracts untouched
+	TArray<FNeutronContractDeltaEntry> Entries;
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		FNeutronContractDeltaEntry& Entry          = Entries.AddDefaulted_GetRef();
+		uint8                       OperationValue = 0;
+		Reader << OperationValue << Entry.Identifier;
+		Entry.Operation = static_cast<ENeutronContractDeltaOperation>(OperationValue);
+
+		if (Entry.Operation == ENeutronContractDeltaOperation::Add)
+		{
+			TSharedPtr<FJsonValue> Value = ReadContractValue(Reader);
+			if (Value.IsValid() && Value->Type == EJson::Object)
+			{
+				Entry.Data = Value->AsObject();
+			}
+			else
+			{
+				Reader.SetError();
+			}
+		}
+		else if (Entry.Operation == ENeutronContractDeltaOperation::Update)
+		{
+			int32 FieldCount = 0;
+			Reader << Entry.Version << FieldCount;
+			if (FieldCount < 0 || FieldCount > Reader.TotalSize() - Reader.Tell())
+			{
+				Reader.SetError();
+			}
+
+			for (int32 Index = 0; Index < FieldCount && !Reader.IsError(); Index++)
+			{
+				FString FieldName;
+				Reader << FieldName;
+				Entry.Fields.Emplace(FieldName, ReadContractValue(Reader));
+			}
+		}
+		else if (OperationValue > static_cast<uint8>(ENeutronContractDeltaOperation::Track))
+		{
+			Reader.SetError();
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		NERR("UNeutronContractManager::ApplyDelta : corrupted delta");
+		return false;
+	}
+
+	// Apply operations without recording them for the next delta, which would send them back
+	TGuardValue<bool> ApplyingDeltaGuard(ApplyingDelta, true);
+	for (const FNeutronContractDeltaEntry& Entry : Entries)
+	{
+		if (Entry.Operation == ENeutronContractDeltaOperation::Reset)
+		{
+			ResetContracts();
+		}
+		else if (Entry.Operation == ENeutronContractDeltaOperation::Remove)
+		{
+			TSharedPtr<FNeutronContract> Contract = ContractsById.FindRef(Entry.Identifier);
+			if (Contract.IsValid())
+			{
+				RemoveContract(Contract);
+			}
+		}
+		else if (Entry.Operation == ENeutronContractDeltaOperation::Add)
+		{
+			if (!ContractsById.Contains(Entry.Identifier))
+			{
+				TSharedPtr<FNeutronContract> Contract = LoadContract(Entry.Data);
+				if (Contract.IsValid())
+				{
+					AddContract(Contract);
+				}
+			}
+		}
+		else if (Entry.Operation == ENeutronContractDeltaOperation::Update)
+		{
+			// Older updates than the local state are ignored
+			TSharedPtr<FNeutronContract> Contract = ContractsById.FindRef(Entry.Identifier);
+			if (Contract.IsValid() && Entry.Version > Contract->Version)
+			{
+				TSharedRef<FJsonObject> Data = Contract->Save();
+				for (const TPair<FString, TSharedPtr<FJsonValue>>& Field : Entry.Fields)
+				{
+					if (Field.Value.IsValid())
+					{
+						Data->SetField(Field.Key, Field.Value);
+					}
+					else
+					{
+						Data->RemoveField(Field.Key);
+					}
+				}
+
+				Data->SetNumberField("Version", Entry.Version);
+				Contract->Load(Data);
+				Contract->DirtyFields.Empty();
+			}
+		}
+		else if (Entry.Operation == ENeutronContractDeltaOperation::Track)
+		{
+			TSharedPtr<FNeutronContract> Contract = ContractsById.FindRef(Entry.Identifier);
+			CurrentTrackedContract                = Contract.IsValid() ? CurrentContracts.Find(Contract) : INDEX_NONE;
+			UpdateTickPriority();
+		}
+	}
+
+	return true;
+}
+
+/*----------------------------------------------------
+    Tick
+----------------------------------------------------*/
+
+TStatId UNeutronContractManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNeutronContractManager, STATGROUP_NeutronContracts);
+}
+
+void UNeutronContractManager::Tick(float DeltaTime)
+{
+	TickContracts(DeltaTime);
+
+	// Don't build deltas nobody listens to, nor let changes pile up for them
+	if (!ContractDeltaDelegate.IsBound())
+	{
+		ClearDelta();
+		return;
+	}
+
+	// Publish contract changes
+	TArray<uint8> Delta;
+	if (BuildDelta(Delta))
+	{
+		ContractDeltaDelegate.Broadcast(Delta);
+	}
+}
+
+void UNeutronContractManager::TickContracts(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NeutronContracts_Tick);
+
+	TickTime += DeltaTime;
+	TickStats.EvaluatedContracts = 0;
+	TickStats.DeferredContracts  = 0;
+
+	TArray<FNeutronContractListener>* TickListeners = Listeners.Find(ENeutronContratEventType::Tick);
+	if (TickListeners == nullptr || TickListeners->Num() == 0)
+	{
+		return;
+	}
+
+	const double Budget        = CVarNeutronContractTickBudget.GetValueOnGameThread();
+	const uint64 StartCycles   = FPlatformTime::Cycles64();
+	const uint64 BudgetCycles  = Budget > 0 ? static_cast<uint64>(Budget / (1000000.0 * FPlatformTime::GetSecondsPerCycle64())) : 0;
+	const int32  ListenerCount = TickListeners->Num();
+	int32        NextCursor    = INDEX_NONE;
+	int32        SlicedCount   = 0;
+
+	// Precise and priority contracts are ticked every frame, others in turn until the budget runs out, with at least one per frame
+	FNeutronContractEvent Event(ENeutronContratEventType::Tick);
+	DispatchDepth++;
+	for (int32 Offset = 0; Offset < ListenerCount; Offset++)
+	{
+		const int32               Index    = (TickCursor + Offset) % ListenerCount;
+		FNeutronContractListener& Listener = (*TickListeners)[Index];
+		if (!Listener.Active || (Listener.Filter.IsValid() && Listener.Filter != Event.Target))
+		{
+			continue;
+		}
+
+		if (!Listener.Precise && !Listener.Priority && Budget > 0)
+		{
+			if (NextCursor == INDEX_NONE && SlicedCount > 0 && FPlatformTime::Cycles64() - StartCycles > BudgetCycles)
+			{
+				NextCursor = Index;
+			}
+
+			if (NextCursor != INDEX_NONE)
+			{
+				TickStats.DeferredContracts++;
+				continue;
+			}
+
+			SlicedCount++;
+		}
+
+		Event.DeltaTime       = static_cast<float>(TickTime - Listener.LastTickTime);
+		Listener.LastTickTime = TickTime;
+
+		Listener.Contract->OnEvent(Event);
+		TickStats.EvaluatedContracts++;
+	}
+	DispatchDepth--;
+
+	// Resume with the first deferred contract next frame
+	if (NextCursor != INDEX_NONE)
+	{
+		TickCursor = NextCursor;
+	}
+
+	// Update statistics
+	const uint64 ElapsedCycles = FPlatformTime::Cycles64() - StartCycles;
+	TickStats.LastTickTime     = 1000000.0 * FPlatformTime::ToSeconds64(ElapsedCycles);
+	if (Budget > 0 && ElapsedCycles > BudgetCycles)
+	{
+		TickStats.OverrunFrames++;
+	}
+
+	SET_DWORD_STAT(STAT_NeutronContracts_Evaluated, TickStats.EvaluatedContracts);
+	SET_DWORD_STAT(STAT_NeutronContracts_Deferred, TickStats.DeferredContracts);
+	SET_DWORD_STAT(STAT_NeutronContracts_Overruns, TickStats.OverrunFrames);
+	SET_FLOAT_STAT(STAT_NeutronContracts_LastTick, TickStats.LastTickTime);
+
+	// Wrap the cursor once removed contracts are gone
+	FlushSubscriptions();
+	TickListeners = Listeners.Find(ENeutronContratEventType::Tick);
+	TickCursor    = TickListeners && TickListeners->Num() > 0 ? TickCursor % TickListeners->Num() : 0;
+}
+
+/*----------------------------------------------------
+    Test contract
+----------------------------------------------------*/
+
+/** Contract shared by the contract benchmark and tests, completing itself after a number of events if set */
+class FNeutronTestContract : public FNeutronContract
+{
+public:
+
+	FNeutronTestContract(int32 Events = 0, FGuid Filter = FGuid(), bool Ticking = true)
+		: RemainingEvents(Events), EventFilter(Filter), ShouldTick(Ticking), Completed(false), EventCount(0), Counter(0)
+	{
+		Type          = ENeutronContractType::Tutorial;
+		Details.Title = FText::FromString(Identifier.ToString());
+	}
+
+	virtual TSharedRef<FJsonObject> Save() const override
+	{
+		TSharedRef<FJsonObject> Data = FNeutronContract::Save();
+
+		Data->SetNumberField("RemainingEvents", RemainingEvents);
+		Data->SetStringField("EventFilter", EventFilter.ToString());
+		Data->SetNumberField("Counter", Counter);
+		Data->SetStringField("Label", Label);
+
+		return Data;
+	}
+
+	virtual void Load(const TSharedPtr<FJsonObject>& Data) override
+	{
+		FNeutronContract::Load(Data);
+
+		FString FilterString;
+		Data->TryGetNumberField("RemainingEvents", RemainingEvents);
+		Data->TryGetStringField("EventFilter", FilterString);
+		FGuid::Parse(FilterString, EventFilter);
+		Data->TryGetNumberField("Counter", Counter);
+		Data->TryGetStringField("Label", Label);
+
+		Details.Title = FText::FromString(Identifier.ToString());
+	}
+
+	virtual TArray<FNeutronContractSubscription> GetSubscriptions() const override
+	{
+		if (ShouldTick)
+		{
+			return {FNeutronContractSubscription(ENeutronContratEventType::Tick, EventFilter)};
+		}
+		else
+		{
+			return {};
+		}
+	}
+
+	virtual void OnEvent(const FNeutronContractEvent& Event) override
+	{
+		EventCount++;
+
+		if (RemainingEvents > 0)
+		{
+			RemainingEvents--;
+			if (RemainingEvents == 0 && !Completed && Manager.IsValid())
+			{
+				Completed = true;
+				Manager->CompleteContract(AsShared());
+			}
+		}
+	}
+
+	void Update(int32 Value)
+	{
+		Counter = Value;
+		MarkDirty("Counter");
+
+		Label = FString::Printf(TEXT("Step %d"), Value);
+		MarkDirty("Label");
+	}
+
+	int32   RemainingEvents;
+	FGuid   EventFilter;
+	bool    ShouldTick;
+	bool    Completed;
+	int32   EventCount;
+	int32   Counter;
+	FString Label;
+};
+
+/*----------------------------------------------------
+    Console commands
+----------------------------------------------------*/
+
+static FAutoConsoleCommand NeutronBenchmarkContractsCommand(TEXT("Neutron.BenchmarkContracts"),
+	TEXT("Compare the per-frame cost of broadcasting tick events to every contract with the event bus - takes a contract count, a frame "
+		 "count and the percentage of contracts subscribed to ticks"),
+	FConsoleCommandWithArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args)
+		{
+			const int32 ContractCount = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+			const int32 FrameCount    = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100;
+			const int32 TickingRatio  = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 10;
+			if (ContractCount <= 0 || FrameCount <= 0)
+			{
+				NERR("Neutron.BenchmarkContracts : expected a contract count and a frame count");
+				return;
+			}
+
+			// Build contracts
+			UNeutronContractManager*             Manager = NewObject<UNeutronContractManager>(GetTransientPackage());
+			TArray<TSharedPtr<FNeutronContract>> Contracts;
+			for (int32 Index = 0; Index < ContractCount; Index++)
+			{
+				bool                         Ticking  = (Index * 100) / ContractCount < TickingRatio;
+				TSharedPtr<FNeutronContract> Contract = MakeShared<FNeutronTestContract>(0, FGuid(), Ticking);
+				for (const FNeutronContractSubscription& Subscription : Contract->GetSubscriptions())
+				{
+					Manager->Subscribe(Contract, Subscription);
+				}
+				Contracts.Add(Contract);
+			}
+			// Previous tick, which broadcast the event by value to a copy of the contract list
+			auto BroadcastEvent = [](const TArray<TSharedPtr<FNeutronContract>>& CurrentContracts, FNeutronContractEvent Event)
+			{
+				TArray<TSharedPtr<FNeutronContract>> SafeCurrentContracts = CurrentContracts;
+				for (TSharedPtr<FNeutronContract> Contract : SafeCurrentContracts)
+				{
+					Contract->OnEvent(Event);
+				}
+			};
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < FrameCount; Frame++)
+			{
+				BroadcastEvent(Contracts, ENeutronContratEventType::Tick);
+			}
+			double BroadcastTime = FPlatformTime::Seconds() - StartTime;
+
+			// Current tick through subscriptions, without a budget so that every subscribed contract is ticked each frame
+			const float PreviousBudget = CVarNeutronContractTickBudget.GetValueOnGameThread();
+			CVarNeutronContractTickBudget->Set(0.0f, ECVF_SetByConsole);
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < FrameCount; Frame++)
+			{
+				Manager->Tick(1.0f / 60.0f);
+			}
+			double DispatchTime = FPlatformTime::Seconds() - StartTime;
+
+			CVarNeutronContractTickBudget->Set(PreviousBudget, ECVF_SetByConsole);
+
+			NLOG("Neutron.BenchmarkContracts : %d contracts, %d%% ticking : broadcast %.2fus per frame, event bus %.2fus per frame",
+				ContractCount, TickingRatio, 1000000.0 * BroadcastTime / FrameCount, 1000000.0 * DispatchTime / FrameCount);
+
+			Manager->MarkAsGarbage();
+		}));
+
+/*----------------------------------------------------
+    Automation tests
+----------------------------------------------------*/
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Check that contract deltas applied to another contract manager match full snapshots, and survive binary saves */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNeutronContractDeltaTest, "Neutron.Contracts.Deltas",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNeutronContractDeltaTest::RunTest(const FString& Parameters)
+{
+	const int32 ContractCount = 1000;
+
+	// Create a source manager and a mirror of it
+	TArray<TSharedPtr<FNeutronTestContract>> SourceContracts;
+	UNeutronContractManager*                 Source = NewObject<UNeutronContractManager>(GetTransientPackage());
+	UNeutronContractManager*                 Mirror = NewObject<UNeutronContractManager>(GetTransientPackage());
+
+	// Register the test contract type, keeping track of the source contracts to update them
+	Source->RegisterContractType(ENeutronContractType::Tutorial, FNeutronContractFactory::CreateLambda(
+		[&SourceContracts](UNeutronGameInstance* CurrentGameInstance)
+		{
+			TSharedPtr<FNeutronTestContract> Contract = MakeShared<FNeutronTestContract>();
+			SourceContracts.Add(Contract);
+			return Contract;
+		}));
+	Mirror->RegisterContractType(ENeutronContractType::Tutorial,
+		FNeutronContractFactory::CreateLambda(
+			[](UNeutronGameInstance* CurrentGameInstance)
+			{
+				return MakeShared<FNeutronTestContract>();
+			}),
+		FNeutronContractSerializer::CreateLambda(
+			[](FNeutronContract& Contract, FArchive& Archive)
+			{
+				FNeutronTestContract& TestContract = static_cast<FNeutronTestContract&>(Contract);
+				Archive << TestContract.Counter;
+				Archive << TestContract.Label;
+			}));
+
+	// Load the initial contracts
+	FNeutronContractManagerSave InitialData;
+	for (int32 Index = 0; Index < ContractCount; Index++)
+	{
+		InitialData.Contracts.AddDefaulted_GetRef().JsonObject = FNeutronTestContract().Save();
+	}
+	InitialData.CurrentTrackedContract = 0;
+	Source->Load(InitialData);
+
+	// Check that the mirror state matches the source snapshot after each delta
+	auto MatchesSource = [Source, Mirror]()
+	{
+		FNeutronContractManagerSave SourceData = Source->Save(ENeutronSaveFormat::Json);
+		FNeutronContractManagerSave MirrorData = Mirror->Save(ENeutronSaveFormat::Json);
+		if (SourceData.Contracts.Num() != MirrorData.Contracts.Num() ||
+			SourceData.CurrentTrackedContract != MirrorData.CurrentTrackedContract)
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < SourceData.Contracts.Num(); Index++)
+		{
+			if (UNeutronSaveManager::JsonToString(SourceData.Contracts[Index].JsonObject) !=
+				UNeutronSaveManager::JsonToString(MirrorData.Contracts[Index].JsonObject))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	// Update a third of the contracts each round
+	bool  Success      = true;
+	int64 DeltaSize    = 0;
+	int64 SnapshotSize = 0;
+	for (int32 Round = 0; Round < 5 && Success; Round++)
+	{
+		for (int32 Index = Round % 3; Index < SourceContracts.Num(); Index += 3)
+		{
+			SourceContracts[Index]->Update(Round * ContractCount + Index);
+		}
+
+		TArray<uint8> Delta;
+		Source->BuildDelta(Delta);
+		Success = TestTrue(FString::Printf(TEXT("Delta applies at round %d"), Round), Mirror->ApplyDelta(Delta)) &&
+		          TestTrue(FString::Printf(TEXT("Mirror matches the source snapshot at round %d"), Round), MatchesSource());
+
+		DeltaSize += Delta.Num();
+		for (const FJsonObjectWrapper& ContractData : Source->Save(ENeutronSaveFormat::Json).Contracts)
+		{
+			SnapshotSize += UNeutronSaveManager::JsonToString(ContractData.JsonObject).Len();
+		}
+	}
+
+	// Check that the mirror survives a binary save, written with its serializer
+	if (Success)
+	{
+		TArray<uint8>               SaveBytes;
+		FNeutronContractManagerSave MirrorData = Mirror->Save(ENeutronSaveFormat::Binary);
+		FMemoryWriter               Writer(SaveBytes, true);
+		MirrorData.Serialize(Writer);
+
+		FNeutronContractManagerSave LoadedData;
+		FMemoryReader               Reader(SaveBytes, true);
+		LoadedData.Serialize(Reader);
+		Mirror->Load(LoadedData);
+		TestFalse(TEXT("Binary save reads back"), Reader.IsError());
+		TestTrue(TEXT("Mirror matches the source snapshot after a binary save"), MatchesSource());
+	}
+
+	AddInfo(
+		FString::Printf(TEXT("%d contracts, %lld bytes of deltas for %lld bytes of snapshots"), ContractCount, DeltaSize, SnapshotSize));
+
+	Source->MarkAsGarbage();
+	Mirror->MarkAsGarbage();
+
+	return true;
+}
+
+/** Get the physical memory used by the process in megabytes */
+static double GetContractTestMemoryMegabytes()
+{
+	return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+}
+
+/** Stress the contract manager with contracts completing during dispatch and time-sliced ticks, reporting latency and memory */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNeutronContractStressTest, "Neutron.Contracts.Stress",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNeutronContractStressTest::RunTest(const FString& Parameters)
+{
+	const int32  ContractCount = 5000;
+	const int32  FrameCount    = 200;
+	const double StartMemory   = GetContractTestMemoryMegabytes();
+	double       PeakMemory    = StartMemory;
+
+	// Register the test contract type through the creation callback
+	TArray<TSharedPtr<FNeutronTestContract>> Contracts;
+	UNeutronContractManager*                 Manager = NewObject<UNeutronContractManager>(GetTransientPackage());
+	Manager->BeginPlay(nullptr, FNeutronContractCreationCallback::CreateLambda(
+		[&Contracts](ENeutronContractType Type, UNeutronGameInstance* CurrentGameInstance)
+		{
+			TSharedPtr<FNeutronTestContract> Contract = MakeShared<FNeutronTestContract>();
+			Contracts.Add(Contract);
+			return Contract;
+		}));
+
+	// Spawn contracts with varied lifetimes, a tenth of them only receiving targeted events
+	const FGuid                 Target = FGuid::NewGuid();
+	FNeutronContractManagerSave InitialData;
+	for (int32 Index = 0; Index < ContractCount; Index++)
+	{
+		const int32 Lifetime = 1 + (Index * 7919) % (2 * FrameCount);
+		InitialData.Contracts.AddDefaulted_GetRef().JsonObject = FNeutronTestContract(Lifetime, Index % 10 == 0 ? Target : FGuid()).Save();
+	}
+	InitialData.CurrentTrackedContract = ContractCount / 2;
+	Manager->Load(InitialData);
+	PeakMemory = FMath::Max(PeakMemory, GetContractTestMemoryMegabytes());
+
+	// Save round trip
+	FNeutronContractManagerSave FirstSave = Manager->Save(ENeutronSaveFormat::Json);
+	Contracts.Empty();
+	Manager->Load(FirstSave);
+	FNeutronContractManagerSave SecondSave = Manager->Save(ENeutronSaveFormat::Json);
+	bool                        SaveMatches =
+		FirstSave.Contracts.Num() == SecondSave.Contracts.Num() && FirstSave.CurrentTrackedContract == SecondSave.CurrentTrackedContract;
+	for (int32 Index = 0; SaveMatches && Index < FirstSave.Contracts.Num(); Index++)
+	{
+		SaveMatches = UNeutronSaveManager::JsonToString(FirstSave.Contracts[Index].JsonObject) ==
+		              UNeutronSaveManager::JsonToString(SecondSave.Contracts[Index].JsonObject);
+	}
+	TestTrue(TEXT("Contracts are unchanged through a save round trip"), SaveMatches);
+
+	// Find the tracked contract
+	auto FindTrackedContract = [&Contracts](const FString& Title)
+	{
+		TSharedPtr<FNeutronTestContract> TrackedContract;
+		for (TSharedPtr<FNeutronTestContract> Contract : Contracts)
+		{
+			if (Contract->GetDisplayDetails().Title.ToString() == Title)
+			{
+				TrackedContract = Contract;
+			}
+		}
+		return TrackedContract;
+	};
+	const FString                    TrackedTitle    = Manager->GetContractDetails(Manager->GetTrackedContract()).Title.ToString();
+	TSharedPtr<FNeutronTestContract> TrackedContract = FindTrackedContract(TrackedTitle);
+	if (!TestTrue(TEXT("Tracked contract is found after loading"), TrackedContract.IsValid()))
+	{
+		Manager->MarkAsGarbage();
+		return true;
+	}
+
+	// The tracked index must follow the tracked contract as others complete
+	auto IsTrackedIndexValid = [&]()
+	{
+		const int32 TrackedIndex = Manager->GetTrackedContract();
+		if (TrackedContract->Completed)
+		{
+			return TrackedIndex == INDEX_NONE;
+		}
+		else
+		{
+			return TrackedIndex != INDEX_NONE && Manager->GetContractDetails(TrackedIndex).Title.ToString() == TrackedTitle;
+		}
+	};
+
+	// Dispatch events with contracts completing along the way
+	double TotalDispatchTime = 0;
+	double MaxDispatchTime   = 0;
+	int32  EventCount        = 0;
+	for (int32 Frame = 0; Frame < FrameCount; Frame++)
+	{
+		for (const FNeutronContractEvent& Event :
+			{FNeutronContractEvent(ENeutronContratEventType::Tick), FNeutronContractEvent(ENeutronContratEventType::Tick, Target)})
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Manager->OnEvent(Event);
+			const double DispatchTime = FPlatformTime::Seconds() - StartTime;
+
+			TotalDispatchTime += DispatchTime;
+			MaxDispatchTime = FMath::Max(MaxDispatchTime, DispatchTime);
+			EventCount++;
+		}
+		PeakMemory = FMath::Max(PeakMemory, GetContractTestMemoryMegabytes());
+
+		if (!TestTrue(FString::Printf(TEXT("Tracked contract index is valid at frame %d"), Frame), IsTrackedIndexValid()))
+		{
+			break;
+		}
+	}
+	const int32 DispatchRemainingCount = Manager->GetContractCount();
+
+	// Tick the initial contracts again with a tiny budget, so that most are deferred while others complete mid-tick
+	const float PreviousBudget = CVarNeutronContractTickBudget.GetValueOnGameThread();
+	CVarNeutronContractTickBudget->Set(1.0f, ECVF_SetByConsole);
+	Contracts.Empty();
+	Manager->Load(FirstSave);
+	TrackedContract = FindTrackedContract(TrackedTitle);
+
+	TMap<const FNeutronTestContract*, int32> InitialEvents;
+	for (TSharedPtr<FNeutronTestContract> Contract : Contracts)
+	{
+		InitialEvents.Add(Contract.Get(), Contract->RemainingEvents);
+	}
+
+	int32 SlicedFrames = 0;
+	for (int32 Frame = 0; Frame < FrameCount && TrackedContract.IsValid(); Frame++)
+	{
+		Manager->Tick(1.0f / 60.0f);
+		SlicedFrames += Manager->GetTickStats().DeferredContracts > 0 ? 1 : 0;
+		PeakMemory = FMath::Max(PeakMemory, GetContractTestMemoryMegabytes());
+
+		// Contracts ticked in turn must never be more than one tick apart, or the cursor skipped some of them, while untargeted ticks
+		// must never reach contracts only listening for a target
+		int32 MinTicks         = MAX_int32;
+		int32 MaxTicks         = 0;
+		bool  FiltersRespected = true;
+		for (TSharedPtr<FNeutronTestContract> Contract : Contracts)
+		{
+			const int32 Ticks = InitialEvents[Contract.Get()] - Contract->RemainingEvents;
+			if (Contract->EventFilter.IsValid())
+			{
+				FiltersRespected &= Ticks == 0;
+			}
+			else if (!Contract->Completed && Contract != TrackedContract)
+			{
+				MinTicks = FMath::Min(MinTicks, Ticks);
+				MaxTicks = FMath::Max(MaxTicks, Ticks);
+			}
+		}
+
+		const bool FairTicks = MinTicks == MAX_int32 || MaxTicks - MinTicks <= 1;
+		if (!TestTrue(FString::Printf(TEXT("Sliced ticks are fair at frame %d"), Frame), FairTicks) ||
+			!TestTrue(FString::Printf(TEXT("Untargeted ticks skip filtered contracts at frame %d"), Frame), FiltersRespected) ||
+			!TestTrue(FString::Printf(TEXT("Tracked contract index is valid at sliced frame %d"), Frame), IsTrackedIndexValid()))
+		{
+			break;
+		}
+	}
+	CVarNeutronContractTickBudget->Set(PreviousBudget, ECVF_SetByConsole);
+
+	TestTrue(TEXT("Tracked contract is found after reloading"), TrackedContract.IsValid());
+	TestTrue(TEXT("Sliced ticks deferred contracts"), SlicedFrames > 0);
+
+	AddInfo(FString::Printf(TEXT("%d contracts, %d left after dispatch, dispatch %.2fus average, %.2fus max per event"), ContractCount,
+		DispatchRemainingCount, 1000000.0 * TotalDispatchTime / FMath::Max(EventCount, 1), 1000000.0 * MaxDispatchTime));
+	AddInfo(FString::Printf(TEXT("Sliced ticks deferred contracts on %d frames out of %d, %d contracts left"), SlicedFrames, FrameCount,
+		Manager->GetContractCount()));
+	AddInfo(FString::Printf(TEXT("Peak memory +%.1f MB, process peak memory %.1f MB"), PeakMemory - StartMemory,
+		FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0)));
+
+	Manager->MarkAsGarbage();
+
+	return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
+
 #undef LOCTEXT_NAMESPACE
@@ -5,9 +5,12 @@
 #include "CoreMinimal.h"
 #include "Tickable.h"
 #include "Dom/JsonObject.h"
+#include "JsonObjectWrapper.h"
 
 #include "NeutronContractManager.generated.h"
 
+enum class ENeutronSaveFormat : uint8;
+
 /*----------------------------------------------------
     Supporting types
 ----------------------------------------------------*/
@@ -17,7 +20,7 @@ struct FNeutronContractDetails
 {
 	FText Title;
 	FText Description;
-	float Progress;
+	float Progress = 0.0f;
 };
 
 /** Contract types */
@@ -35,10 +38,60 @@ enum ENeutronContratEventType
 /** Contract event data */
 struct FNeutronContractEvent
 {
-	FNeutronContractEvent(ENeutronContratEventType T) : Type(T)
+	FNeutronContractEvent(ENeutronContratEventType T, FGuid Id = FGuid()) : Type(T), Target(Id), DeltaTime(0.0f)
+	{}
+
+	ENeutronContratEventType Type;
+	FGuid                    Target;
+
+	// Time since the contract last received a tick, which can span several frames when ticks are time-sliced
+	float DeltaTime;
+};
+
+/** Contract event subscription, optionally restricted to events targeting a particular asset */
+struct FNeutronContractSubscription
+{
+	FNeutronContractSubscription(ENeutronContratEventType T, FGuid Id = FGuid()) : Type(T), Filter(Id)
 	{}
 
 	ENeutronContratEventType Type;
+	FGuid                    Filter;
+};
+
+/** Contract registered for an event type */
+struct FNeutronContractListener
+{
+	FNeutronContractListener(TSharedPtr<class FNeutronContract> ContractParam, FGuid FilterParam, double Time)
+		: Contract(ContractParam), Filter(FilterParam), Active(true), Precise(false), Priority(false), LastTickTime(Time)
+	{}
+
+	TSharedPtr<class FNeutronContract> Contract;
+	FGuid                              Filter;
+	bool                               Active;
+
+	// Time slicing state
+	bool   Precise;
+	bool   Priority;
+	double LastTickTime;
+};
+
+/** Contract tick statistics */
+struct FNeutronContractTickStats
+{
+	FNeutronContractTickStats() : EvaluatedContracts(0), DeferredContracts(0), OverrunFrames(0), LastTickTime(0)
+	{}
+
+	// Contracts ticked during the last frame
+	int32 EvaluatedContracts;
+
+	// Contracts that were left for the next frames to stay within the budget during the last frame
+	int32 DeferredContracts;
+
+	// Frames where ticking contracts took longer than the budget
+	int32 OverrunFrames;
+
+	// Duration of the last frame's contract ticks in microseconds
+	double LastTickTime;
 };
 
 /** Save data */
@@ -47,17 +100,53 @@ struct FNeutronContractManagerSave
 {
 	GENERATED_BODY()
 
+	/** Write contracts to binary saves as serializer blocks or binary JSON, instead of tagged properties */
+	bool Serialize(FArchive& Ar);
+
+	// Contracts saved as nested JSON strings by previous versions, only read
 	UPROPERTY()
 	TArray<FString> ContractSaveData;
 
+	UPROPERTY()
+	TArray<FJsonObjectWrapper> Contracts;
+
 	UPROPERTY()
 	int32 CurrentTrackedContract = INDEX_NONE;
+
+	// Blocks written by the serializer registered for each contract type, empty for others, only stored in binary saves
+	TArray<TArray<uint8>> ContractBlocks;
+};
+
+template <>
+struct TStructOpsTypeTraits<FNeutronContractManagerSave> : public TStructOpsTypeTraitsBase2<FNeutronContractManagerSave>
+{
+	enum
+	{
+		WithSerializer = true
+	};
 };
 
 // Contract creation delegate
 DECLARE_DELEGATE_RetVal_TwoParams(TSharedPtr<class FNeutronContract>, FNeutronContractCreationCallback, ENeutronContractType Type,
 	class UNeutronGameInstance* CurrentGameInstance);
 
+// Contract factory delegate for a single contract type
+DECLARE_DELEGATE_RetVal_OneParam(
+	TSharedPtr<class FNeutronContract>, FNeutronContractFactory, class UNeutronGameInstance* CurrentGameInstance);
+
+// Contract serializer delegate for a single contract type, reading or writing the fields of a contract in binary saves
+DECLARE_DELEGATE_TwoParams(FNeutronContractSerializer, class FNeutronContract& Contract, FArchive& Archive);
+
+/** Registered contract type */
+struct FNeutronContractTypeInfo
+{
+	FNeutronContractFactory    Factory;
+	FNeutronContractSerializer Serializer;
+};
+
+// Contract delta delegate
+DECLARE_MULTICAST_DELEGATE_OneParam(FNeutronContractDeltaDelegate, const TArray<uint8>& Delta);
+
 /*----------------------------------------------------
     Base contract definitions
 ----------------------------------------------------*/
@@ -67,7 +156,7 @@ class NEUTRON_API FNeutronContract : public TSharedFromThis<FNeutronContract>
 {
 public:
 
-	FNeutronContract() : GameInstance(nullptr)
+	FNeutronContract() : GameInstance(nullptr), Identifier(FGuid::NewGuid()), Version(0)
 	{}
 
 	virtual ~FNeutronContract()
@@ -82,6 +171,30 @@ public:
 	/** Load this object from save data */
 	virtual void Load(const TSharedPtr<FJsonObject>& Data);
 
+	/** Whether this contract needs a tick every frame, instead of being time-sliced with other contracts */
+	virtual bool NeedsPreciseTick() const
+	{
+		return false;
+	}
+
+	/** Get the unique identifier of this contract */
+	FGuid GetIdentifier() const
+	{
+		return Identifier;
+	}
+
+	/** Get the version of this contract, incremented with every change */
+	uint32 GetVersion() const
+	{
+		return Version;
+	}
+
+	/** Get the completion ratio of this contract */
+	float GetProgress() const
+	{
+		return Details.Progress;
+	}
+
 	/** Get a numerical type identifier for this contract */
 	virtual ENeutronContractType GetType() const
 	{
@@ -94,15 +207,34 @@ public:
 		return Details;
 	}
 
+	/** Get the events this contract needs to receive - every tick by default */
+	virtual TArray<FNeutronContractSubscription> GetSubscriptions() const
+	{
+		return {FNeutronContractSubscription(ENeutronContratEventType::Tick)};
+	}
+
 	/** Update this contract */
 	virtual void OnEvent(const FNeutronContractEvent& Event){};
 
+protected:
+
+	/** Flag a field written by Save as changed, so that it is sent with the next contract delta */
+	void MarkDirty(const FString& FieldName);
+
 protected:
 
 	// Local state
 	ENeutronContractType        Type;
 	FNeutronContractDetails     Details;
 	class UNeutronGameInstance* GameInstance;
+
+	// Delta state
+	FGuid                                         Identifier;
+	uint32                                        Version;
+	TSet<FString>                                 DirtyFields;
+	TWeakObjectPtr<class UNeutronContractManager> Manager;
+
+	friend class UNeutronContractManager;
 };
 
 /*----------------------------------------------------
@@ -125,8 +257,12 @@ public:
 	    Loading & saving
 	----------------------------------------------------*/
 
+	/** Save contracts for the current save format */
 	FNeutronContractManagerSave Save() const;
 
+	/** Save contracts for a save format, building only the representation it stores for each contract */
+	FNeutronContractManagerSave Save(ENeutronSaveFormat Format) const;
+
 	void Load(const FNeutronContractManagerSave& SaveData);
 
 	/*----------------------------------------------------
@@ -145,9 +281,19 @@ public:
 	/** Start playing on a new level */
 	void BeginPlay(class ANeutronPlayerController* PC, FNeutronContractCreationCallback CreationCallback);
 
-	/** Update all contracts */
+	/** Register the factory for a contract type, used instead of the creation callback, and its optional binary serializer */
+	void RegisterContractType(
+		ENeutronContractType Type, FNeutronContractFactory Factory, FNeutronContractSerializer Serializer = FNeutronContractSerializer());
+
+	/** Send an event to the contracts that subscribed to it */
 	void OnEvent(FNeutronContractEvent Event);
 
+	/** Subscribe a contract to an event type, deferred until the end of the current dispatch if there is one */
+	void Subscribe(TSharedPtr<class FNeutronContract> Contract, FNeutronContractSubscription Subscription);
+
+	/** Remove all subscriptions of a contract, which stops receiving events immediately */
+	void Unsubscribe(TSharedPtr<class FNeutronContract> Contract);
+
 	/*----------------------------------------------------
 	    Game interface
 	----------------------------------------------------*/
@@ -182,6 +328,28 @@ public:
 	/** Get the tracked contract, or INDEX_NONE if none */
 	int32 GetTrackedContract();
 
+	/** Get statistics on time-sliced contract ticks */
+	const FNeutronContractTickStats& GetTickStats() const
+	{
+		return TickStats;
+	}
+
+	/*----------------------------------------------------
+	    Contract deltas
+	----------------------------------------------------*/
+
+	/** Write the changes made to contracts since the last delta, and return false if there were none */
+	bool BuildDelta(TArray<uint8>& Delta);
+
+	/** Apply a delta built by another contract manager */
+	bool ApplyDelta(const TArray<uint8>& Delta);
+
+	/** Get the delegate called with the contract delta after each tick that changed contracts */
+	FNeutronContractDeltaDelegate& OnContractDelta()
+	{
+		return ContractDeltaDelegate;
+	}
+
 	/*----------------------------------------------------
 	    Tick
 	----------------------------------------------------*/
@@ -191,19 +359,61 @@ public:
 	{
 		return ETickableTickType::Always;
 	}
-	virtual TStatId GetStatId() const override
-	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(UNeutronSoundManager, STATGROUP_Tickables);
-	}
-	virtual bool IsTickableWhenPaused() const
+	virtual TStatId GetStatId() const override;
+	virtual bool    IsTickableWhenPaused() const
 	{
-		return true;
+		return false;
 	}
 	virtual bool IsTickableInEditor() const
 	{
 		return false;
 	}
 
+	/*----------------------------------------------------
+	    Internals
+	----------------------------------------------------*/
+
+protected:
+
+	/** Create a contract of a given type from the registered factory, or the creation callback */
+	TSharedPtr<class FNeutronContract> CreateContract(ENeutronContractType Type);
+
+	/** Create and load a contract from its save data */
+	TSharedPtr<class FNeutronContract> LoadContract(const TSharedPtr<FJsonObject>& ContractData);
+
+	/** Create and load a contract from a block written by the serializer of its type */
+	TSharedPtr<class FNeutronContract> LoadContract(const TArray<uint8>& ContractBlock);
+
+	/** Add a contract to the active list and subscribe it to its events */
+	void AddContract(TSharedPtr<class FNeutronContract> Contract);
+
+	/** Remove a contract from the active list and its subscriptions */
+	void RemoveContract(TSharedPtr<class FNeutronContract> Contract);
+
+	/** Remove all contracts and subscriptions */
+	void ResetContracts();
+
+	/** Apply the subscription changes made during dispatch */
+	void FlushSubscriptions();
+
+	/** Notify the player, if there is one */
+	void Notify(const FText& Text);
+
+	/** Record a contract with dirty fields for the next delta */
+	void MarkContractDirty(TSharedPtr<class FNeutronContract> Contract);
+
+	/** Forget the changes recorded for the next delta */
+	void ClearDelta();
+
+	/** Tick contracts within the time budget */
+	void TickContracts(float DeltaTime);
+
+	/** Check whether a contract should be ticked every frame because it is tracked or close to completion */
+	bool IsPriorityContract(const class FNeutronContract* Contract) const;
+
+	/** Update the priority of tick listeners, for a single contract or all of them */
+	void UpdateTickPriority(const class FNeutronContract* Contract = nullptr);
+
 	/*----------------------------------------------------
 	    Data
 	----------------------------------------------------*/
@@ -227,4 +437,28 @@ protected:
 	TSharedPtr<class FNeutronContract>         GeneratedContract;
 	TArray<TSharedPtr<class FNeutronContract>> CurrentContracts;
 	int32                                      CurrentTrackedContract;
+
+	// Contract types
+	TMap<ENeutronContractType, FNeutronContractTypeInfo> ContractTypes;
+
+	// Event bus
+	TMap<ENeutronContratEventType, TArray<FNeutronContractListener>>                Listeners;
+	TArray<TPair<TSharedPtr<class FNeutronContract>, FNeutronContractSubscription>> PendingSubscriptions;
+	int32                                                                           DispatchDepth;
+	bool                                                                            HasInactiveListeners;
+
+	// Time slicing
+	double                    TickTime;
+	int32                     TickCursor;
+	FNeutronContractTickStats TickStats;
+
+	// Contract deltas
+	TMap<FGuid, TSharedPtr<class FNeutronContract>> ContractsById;
+	TArray<FGuid>                                   AddedContracts;
+	TArray<FGuid>                                   RemovedContracts;
+	TArray<TWeakPtr<class FNeutronContract>>        DirtyContracts;
+	bool                                            DeltaReset;
+	bool                                            TrackedContractDirty;
+	bool                                            ApplyingDelta;
+	FNeutronContractDeltaDelegate                   ContractDeltaDelegate;
 };
@@ -85,6 +85,7 @@ void UNeutronGameInstance::Init()
 
 void UNeutronGameInstance::Shutdown()
 {
+	SaveManager->FlushPendingSaves();
 	SessionsManager->Finalize();
 	Super::Shutdown();
 }
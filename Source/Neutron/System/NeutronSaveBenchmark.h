@@ -0,0 +1,49 @@
+// Neutron - Gwennaël Arbona
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NeutronSaveManager.h"
+#include "NeutronSaveBenchmark.generated.h"
+
+/*----------------------------------------------------
+    Development-only save data, only included outside of shipping builds
+----------------------------------------------------*/
+
+/** Random save entry used to test and benchmark the save system */
+USTRUCT()
+struct FNeutronSaveBenchmarkEntry
+{
+	GENERATED_BODY()
+
+	FNeutronSaveBenchmarkEntry() : Count(0), Value(0)
+	{}
+
+	UPROPERTY()
+	FGuid Identifier;
+
+	UPROPERTY()
+	FString Name;
+
+	UPROPERTY()
+	int32 Count;
+
+	UPROPERTY()
+	float Value;
+
+	UPROPERTY()
+	TArray<int32> History;
+
+	UPROPERTY()
+	TArray<FNeutronSaveBenchmarkEntry> Children;
+};
+
+/** Random save data used to test and benchmark the save system */
+USTRUCT()
+struct FNeutronSaveBenchmarkData : public FNeutronSaveDataBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FNeutronSaveBenchmarkEntry> Entries;
+};
@@ -3,6 +3,10 @@
 #include "NeutronSaveManager.h"
 #include "NeutronGameInstance.h"
 
+#if !UE_BUILD_SHIPPING
+#include "NeutronSaveBenchmark.h"
+#endif
+
 #include "Neutron/Neutron.h"
 
 #include "Dom/JsonObject.h"
@@ -11,243 +15,3045 @@
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Async/AsyncWork.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ArchiveProxy.h"
+#include "Serialization/StructuredArchive.h"
+#include "Hash/CityHash.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/ObjectVersion.h"
+#include "UObject/PropertyTag.h"
 #include "Serialization/JsonWriter.h"
 #include "Serialization/JsonSerializer.h"
 #include "Policies/CondensedJsonPrintPolicy.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 
 // Statics
 UNeutronSaveManager* UNeutronSaveManager::Singleton = nullptr;
 
 /*----------------------------------------------------
-    Asynchronous task
+    Profiling
 ----------------------------------------------------*/
 
-class FNeutronAsyncSave : public FNonAbandonableTask
-{
-	friend class FAutoDeleteAsyncTask<FNeutronAsyncSave>;
+DECLARE_STATS_GROUP(TEXT("NeutronSave"), STATGROUP_NeutronSave, STATCAT_Advanced);
 
-public:
+// Save phases
+DECLARE_CYCLE_STAT(TEXT("Serialize"), STAT_NeutronSave_Serialize, STATGROUP_NeutronSave);
+DECLARE_CYCLE_STAT(TEXT("Compress"), STAT_NeutronSave_Compress, STATGROUP_NeutronSave);
+DECLARE_CYCLE_STAT(TEXT("Write"), STAT_NeutronSave_Write, STATGROUP_NeutronSave);
+DECLARE_CYCLE_STAT(TEXT("Read"), STAT_NeutronSave_Read, STATGROUP_NeutronSave);
+DECLARE_CYCLE_STAT(TEXT("Inflate"), STAT_NeutronSave_Inflate, STATGROUP_NeutronSave);
+DECLARE_CYCLE_STAT(TEXT("Parse"), STAT_NeutronSave_Parse, STATGROUP_NeutronSave);
+
+// Last save breakdown
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last save total (ms)"), STAT_NeutronSave_LastSaveTotal, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last save serialize (ms)"), STAT_NeutronSave_LastSaveSerialize, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last save compress (ms)"), STAT_NeutronSave_LastSaveCompress, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last save write (ms)"), STAT_NeutronSave_LastSaveWrite, STATGROUP_NeutronSave);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last save raw bytes"), STAT_NeutronSave_LastSaveRawSize, STATGROUP_NeutronSave);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last save compressed bytes"), STAT_NeutronSave_LastSaveCompressedSize, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last save compression ratio"), STAT_NeutronSave_LastSaveRatio, STATGROUP_NeutronSave);
+
+// Last load breakdown
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last load total (ms)"), STAT_NeutronSave_LastLoadTotal, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last load read (ms)"), STAT_NeutronSave_LastLoadRead, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last load inflate (ms)"), STAT_NeutronSave_LastLoadInflate, STATGROUP_NeutronSave);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last load parse (ms)"), STAT_NeutronSave_LastLoadParse, STATGROUP_NeutronSave);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last load raw bytes"), STAT_NeutronSave_LastLoadRawSize, STATGROUP_NeutronSave);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last load compressed bytes"), STAT_NeutronSave_LastLoadCompressedSize, STATGROUP_NeutronSave);
 
-	FNeutronAsyncSave(
-		UNeutronSaveManager* SaveSystemParam, const FString SaveNameParam, TSharedPtr<FJsonObject> JsonDataParam, bool CompressParam)
-		: SaveName(SaveNameParam), JsonData(JsonDataParam), SaveSystem(SaveSystemParam), Compress(CompressParam)
+CSV_DEFINE_CATEGORY(NeutronSave, true);
+
+/** Breakdown of the save or load running on the current thread */
+struct FNeutronSaveProfile
+{
+	FNeutronSaveProfile()
+		: Serialize(0)
+		, Compress(0)
+		, Write(0)
+		, Read(0)
+		, Inflate(0)
+		, Parse(0)
+		, RawSize(0)
+		, CompressedSize(0)
+		, StartTime(FPlatformTime::Seconds())
 	{}
 
-protected:
+	double Serialize;
+	double Compress;
+	double Write;
+	double Read;
+	double Inflate;
+	double Parse;
+	int64  RawSize;
+	int64  CompressedSize;
+	double StartTime;
+};
 
-	void DoWork()
-	{
-		NLOG("FNeutronAsyncSave::DoWork : started");
+static thread_local FNeutronSaveProfile NeutronSaveProfile;
 
-		SaveSystem->SaveGame(SaveName, JsonData, Compress);
+/** Timer adding its duration to a phase of the current profile, excluding nested phases */
+class FNeutronSavePhaseTimer
+{
+public:
 
-		NLOG("FNeutronAsyncSave::DoWork : done");
+	FNeutronSavePhaseTimer(double& AccumulatorParam) : Accumulator(AccumulatorParam), Parent(Current)
+	{
+		StartTime = FPlatformTime::Seconds();
+		if (Parent)
+		{
+			Parent->Accumulator += StartTime - Parent->StartTime;
+		}
+		Current = this;
 	}
 
-	FORCEINLINE TStatId GetStatId() const
+	~FNeutronSavePhaseTimer()
 	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(FNeutronAsyncSave, STATGROUP_ThreadPoolAsyncTasks);
+		double EndTime = FPlatformTime::Seconds();
+		Accumulator += EndTime - StartTime;
+		if (Parent)
+		{
+			Parent->StartTime = EndTime;
+		}
+		Current = Parent;
 	}
 
 protected:
 
-	FString                 SaveName;
-	TSharedPtr<FJsonObject> JsonData;
-	UNeutronSaveManager*    SaveSystem;
-	bool                    Compress;
-};
+	double&                 Accumulator;
+	FNeutronSavePhaseTimer* Parent;
+	double                  StartTime;
 
-/*----------------------------------------------------
-    Constructor
-----------------------------------------------------*/
+	static thread_local FNeutronSavePhaseTimer* Current;
+};
 
-UNeutronSaveManager::UNeutronSaveManager() : Super(), CurrentSaveData(nullptr), TimeOfLastSave(0)
-{}
+thread_local FNeutronSavePhaseTimer* FNeutronSavePhaseTimer::Current = nullptr;
 
-/*----------------------------------------------------
-    Interface
-----------------------------------------------------*/
+// Profile a save phase in stats, traces and the current profile
+#define NEUTRON_SAVE_SCOPE(Phase)                       \
+	SCOPE_CYCLE_COUNTER(STAT_NeutronSave_##Phase);      \
+	TRACE_CPUPROFILER_EVENT_SCOPE(NeutronSave_##Phase); \
+	FNeutronSavePhaseTimer PhaseTimer##Phase(NeutronSaveProfile.Phase)
 
-bool UNeutronSaveManager::DoesSaveExist(const FString SaveName)
+/** Publish the profile of the last save */
+static void PublishSaveProfile()
 {
-	return IFileManager::Get().FileSize(*GetSaveGamePath(SaveName, true)) >= 0 ||
-	       IFileManager::Get().FileSize(*GetSaveGamePath(SaveName, false)) >= 0;
+	const FNeutronSaveProfile& Profile = NeutronSaveProfile;
+	double                     Total   = (FPlatformTime::Seconds() - Profile.StartTime) * 1000.0;
+	float                      Ratio   = Profile.CompressedSize > 0 ? static_cast<float>(Profile.RawSize) / Profile.CompressedSize : 0.0f;
+
+	SET_FLOAT_STAT(STAT_NeutronSave_LastSaveTotal, Total);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastSaveSerialize, Profile.Serialize * 1000.0);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastSaveCompress, Profile.Compress * 1000.0);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastSaveWrite, Profile.Write * 1000.0);
+	SET_DWORD_STAT(STAT_NeutronSave_LastSaveRawSize, Profile.RawSize);
+	SET_DWORD_STAT(STAT_NeutronSave_LastSaveCompressedSize, Profile.CompressedSize);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastSaveRatio, Ratio);
+
+	CSV_CUSTOM_STAT(NeutronSave, SaveTotalMs, static_cast<float>(Total), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(NeutronSave, SaveRawBytes, static_cast<int32>(Profile.RawSize), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(NeutronSave, SaveCompressedBytes, static_cast<int32>(Profile.CompressedSize), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(NeutronSave, SaveCompressionRatio, Ratio, ECsvCustomStatOp::Set);
+
+	NLOG("UNeutronSaveManager::SaveGame : %.2fms total, %.2fms serialize, %.2fms compress, %.2fms write, %lld bytes to %lld", Total,
+		Profile.Serialize * 1000.0, Profile.Compress * 1000.0, Profile.Write * 1000.0, Profile.RawSize, Profile.CompressedSize);
 }
 
-bool UNeutronSaveManager::DeleteGame(const FString SaveName)
+/** Publish the profile of the last load */
+static void PublishLoadProfile()
 {
-	bool Result = IFileManager::Get().Delete(*GetSaveGamePath(SaveName, false), true) ||
-	              IFileManager::Get().Delete(*GetSaveGamePath(SaveName, true), true);
-	return Result;
+	const FNeutronSaveProfile& Profile = NeutronSaveProfile;
+	double                     Total   = (FPlatformTime::Seconds() - Profile.StartTime) * 1000.0;
+
+	SET_FLOAT_STAT(STAT_NeutronSave_LastLoadTotal, Total);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastLoadRead, Profile.Read * 1000.0);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastLoadInflate, Profile.Inflate * 1000.0);
+	SET_FLOAT_STAT(STAT_NeutronSave_LastLoadParse, Profile.Parse * 1000.0);
+	SET_DWORD_STAT(STAT_NeutronSave_LastLoadRawSize, Profile.RawSize);
+	SET_DWORD_STAT(STAT_NeutronSave_LastLoadCompressedSize, Profile.CompressedSize);
+
+	CSV_CUSTOM_STAT(NeutronSave, LoadTotalMs, static_cast<float>(Total), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(NeutronSave, LoadRawBytes, static_cast<int32>(Profile.RawSize), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(NeutronSave, LoadCompressedBytes, static_cast<int32>(Profile.CompressedSize), ECsvCustomStatOp::Set);
+
+	NLOG("UNeutronSaveManager::LoadGame : %.2fms total, %.2fms read, %.2fms inflate, %.2fms parse, %lld bytes from %lld", Total,
+		Profile.Read * 1000.0, Profile.Inflate * 1000.0, Profile.Parse * 1000.0, Profile.RawSize, Profile.CompressedSize);
 }
 
 /*----------------------------------------------------
-    Internals
+    Save file header
 ----------------------------------------------------*/
 
-void UNeutronSaveManager::SaveGameAsync(const FString SaveName, TSharedPtr<FJsonObject> JsonData, bool Compress)
+// Save file identifiers - legacy compressed saves start with a big-endian size instead
+static constexpr uint32 NeutronSaveMagic           = 0x5641534E;
+static constexpr uint32 NeutronSaveVersion         = 5;
+static constexpr uint32 NeutronSaveVersionStreamed = 2;
+static constexpr uint32 NeutronSaveVersionChecksum = 3;
+static constexpr uint32 NeutronSaveVersionSchema   = 4;
+static constexpr uint32 NeutronSaveVersionStruct   = 5;
+
+// Size of the independently compressed blocks
+static constexpr int32 NeutronSaveBlockSize = 256 * 1024;
+
+// Largest payload accepted when saving and loading, so that damaged headers are rejected before allocating anything
+static constexpr uint32 NeutronSaveMaxSize = 256 * 1024 * 1024;
+
+// Journal identifiers
+static constexpr uint32 NeutronJournalMagic         = 0x4E524A4E;
+static constexpr uint32 NeutronJournalVersion       = 3;
+static constexpr uint32 NeutronJournalVersionSchema = 2;
+static constexpr uint32 NeutronJournalVersionTagged = 3;
+
+// Journal size relative to its base save that triggers a full save
+static constexpr float NeutronJournalCompactionRatio = 0.5f;
+
+// Fields holding the schema version and structure of plain JSON saves, and the checksum of the text preceding it
+static const TCHAR*    NeutronJsonSchemaVersionField = TEXT("NeutronSchemaVersion");
+static const TCHAR*    NeutronJsonStructField        = TEXT("NeutronStruct");
+static const TCHAR*    NeutronJsonChecksumField      = TEXT("NeutronChecksum");
+static const ANSICHAR* NeutronJsonChecksumMarker     = ",\"NeutronChecksum\":";
+
+// Approximate serialized size of a synthetic benchmark save entry
+static constexpr int32 NeutronSaveBenchmarkEntrySize = 192;
+
+// Save index identifiers
+static constexpr uint32 NeutronSaveIndexMagic   = 0x5849534E;
+static constexpr uint32 NeutronSaveIndexVersion = 3;
+
+/** Header for compressed and binary save files */
+struct FNeutronSaveHeader
+{
+	FNeutronSaveHeader()
+		: Magic(NeutronSaveMagic)
+		, Version(NeutronSaveVersion)
+		, Format(0)
+		, Codec(0)
+		, UncompressedSize(0)
+		, BlockSize(NeutronSaveBlockSize)
+		, SchemaVersion(0)
+	{}
+
+	friend FArchive& operator<<(FArchive& Ar, FNeutronSaveHeader& Header)
+	{
+		Ar << Header.Magic;
+		Ar << Header.Version;
+		Ar << Header.Format;
+		Ar << Header.Codec;
+		Ar << Header.UncompressedSize;
+
+		if (Header.Version >= NeutronSaveVersionStreamed)
+		{
+			Ar << Header.BlockSize;
+		}
+
+		if (Header.Version >= NeutronSaveVersionSchema)
+		{
+			Ar << Header.SchemaVersion;
+		}
+
+		if (Header.Version >= NeutronSaveVersionStruct)
+		{
+			Ar << Header.StructPath;
+		}
+
+		return Ar;
+	}
+
+	uint32  Magic;
+	uint32  Version;
+	uint8   Format;
+	uint8   Codec;
+	uint32  UncompressedSize;
+	int32   BlockSize;
+	uint32  SchemaVersion;
+	FString StructPath;
+};
+
+/** Location of a compressed block in a save file, and of its data in the payload */
+struct FNeutronSaveBlock
 {
-	NCHECK(JsonData.IsValid());
+	int64 CompressedOffset;
+	int32 CompressedSize;
+	int64 RawOffset;
+	int32 RawSize;
+};
 
-	SaveListLock.Lock();
+/** Parse JSON save data, failing without asserting when it is damaged */
+static TSharedPtr<FJsonObject> ParseSaveJson(const FString& SaveString)
+{
+	TSharedPtr<FJsonObject>   JsonData;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(SaveString);
 
-	if (SaveList.Find(JsonData) != INDEX_NONE)
+	if (!FJsonSerializer::Deserialize(Reader, JsonData) || !JsonData.IsValid())
 	{
-		NLOG("UNeutronSaveManager::SaveGameAsync : save to '%s' already in progress, aborting", *SaveName);
-		SaveListLock.Unlock();
-		return;
+		NERR("UNeutronSaveManager : failed to parse JSON save data");
+		return nullptr;
 	}
-	else
+
+	return JsonData;
+}
+
+/** Write the properties of a game state structure to the current JSON object one top-level property or array element at a time */
+template <typename WriterType>
+static bool WriteSaveJsonFields(const UScriptStruct* Struct, const void* SaveData, const TSharedRef<WriterType>& Writer)
+{
+	for (TFieldIterator<FProperty> PropIt(Struct); PropIt; ++PropIt)
+	{
+		FProperty*      Property      = *PropIt;
+		FString         Name          = FJsonObjectConverter::StandardizeCase(Property->GetName());
+		const void*     Value         = Property->ContainerPtrToValuePtr<void>(SaveData);
+		FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property);
+
+		// Arrays are usually the bulk of a save, so write them element by element
+		if (ArrayProperty && Property->ArrayDim == 1)
+		{
+			FScriptArrayHelper ArrayHelper(ArrayProperty, Value);
+			Writer->WriteArrayStart(Name);
+			for (int32 Index = 0; Index < ArrayHelper.Num(); Index++)
+			{
+				TSharedPtr<FJsonValue> Element =
+					FJsonObjectConverter::UPropertyToJsonValue(ArrayProperty->Inner, ArrayHelper.GetRawPtr(Index));
+				if (!Element.IsValid() || !FJsonSerializer::Serialize(Element.ToSharedRef(), FString(), Writer, false))
+				{
+					return false;
+				}
+			}
+			Writer->WriteArrayEnd();
+		}
+		else
+		{
+			TSharedPtr<FJsonValue> JsonValue = FJsonObjectConverter::UPropertyToJsonValue(Property, Value);
+			if (!JsonValue.IsValid() || !FJsonSerializer::Serialize(JsonValue.ToSharedRef(), Name, Writer, false))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/** Get the compression format name for a codec */
+static FName GetCodecName(ENeutronSaveCodec Codec)
+{
+	switch (Codec)
 	{
-		SaveList.Add(JsonData);
-		SaveListLock.Unlock();
+		case ENeutronSaveCodec::Zlib:
+			return NAME_Zlib;
+		case ENeutronSaveCodec::Oodle:
+			return NAME_Oodle;
+		case ENeutronSaveCodec::LZ4:
+			return NAME_LZ4;
+		default:
+			return NAME_None;
 	}
+}
+
+/** Write the engine versions that binary data is serialized with */
+static void WriteSaveVersions(FArchive& Archive)
+{
+	int32                   FileVersionUE4  = GPackageFileUEVersion.FileVersionUE4;
+	int32                   FileVersionUE5  = GPackageFileUEVersion.FileVersionUE5;
+	int32                   LicenseeVersion = GPackageFileLicenseeUEVersion;
+	FCustomVersionContainer CustomVersions  = FCurrentCustomVersions::GetAll();
 
-	(new FAutoDeleteAsyncTask<FNeutronAsyncSave>(this, SaveName, JsonData, Compress))->StartBackgroundTask();
+	Archive << FileVersionUE4;
+	Archive << FileVersionUE5;
+	Archive << LicenseeVersion;
+	CustomVersions.Serialize(Archive);
 }
 
-bool UNeutronSaveManager::SaveGame(const FString SaveName, TSharedPtr<FJsonObject> JsonData, bool Compress)
+/** Read the engine versions that binary data was serialized with, and use them for the rest of the archive */
+static void ReadSaveVersions(FArchive& Archive)
 {
-	NLOG("UNeutronSaveManager::SaveGame : saving to '%s'", *SaveName);
+	int32                   FileVersionUE4;
+	int32                   FileVersionUE5;
+	int32                   LicenseeVersion;
+	FCustomVersionContainer CustomVersions;
 
-	NCHECK(JsonData.IsValid());
+	Archive << FileVersionUE4;
+	Archive << FileVersionUE5;
+	Archive << LicenseeVersion;
+	CustomVersions.Serialize(Archive);
 
-	SaveLock.Lock();
+	Archive.SetUEVer(FPackageFileVersion(FileVersionUE4, static_cast<EUnrealEngineObjectUE5Version>(FileVersionUE5)));
+	Archive.SetLicenseeUEVer(LicenseeVersion);
+	Archive.SetCustomVersions(CustomVersions);
+}
+
+/** Top-level property of binary save data, as the byte range of its tagged values */
+struct FNeutronSaveTaggedRange
+{
+	FName Name;
+	int64 Start;
+	int64 End;
+};
 
-	// Initialize
-	bool    Result       = false;
-	FString FileContents = JsonToString(JsonData);
+/** Find the tagged top-level properties of binary save data, and where its tags start after the versions and end before the terminator */
+static bool ReadSaveTaggedRanges(
+	TArrayView<const uint8> Payload, TArray<FNeutronSaveTaggedRange>& Ranges, int64& TagsStart, int64& TagsEnd)
+{
+	FMemoryReaderView Reader(Payload, true);
+	ReadSaveVersions(Reader);
+	TagsStart = Reader.Tell();
 
-	// Serialize the JSON objects and compress
-	if (Compress)
+	// Static arrays have a tag per element, which are kept together
+	FObjectAndNameAsStringProxyArchive ProxyArchive(Reader, true);
+	while (!Reader.IsError())
 	{
-		// Estimate sizes - 4 bytes to store size, 512 byes of margin for small files with higher compressed sizes
-		uint32 DataSize               = FCStringAnsi::Strlen(TCHAR_TO_UTF8(*FileContents));
-		int32  ContentsCompressedSize = DataSize + 512;
-		int32  FullCompressedSize     = ContentsCompressedSize + 4;
+		int64        Start = Reader.Tell();
+		FPropertyTag Tag;
+		ProxyArchive << Tag;
+		if (Reader.IsError())
+		{
+			break;
+		}
+		else if (Tag.Name.IsNone())
+		{
+			TagsEnd = Start;
+			return true;
+		}
+
+		int64 End = Reader.Tell() + Tag.Size;
+		if (Tag.Size < 0 || End > Reader.TotalSize())
+		{
+			break;
+		}
+		Reader.Seek(End);
+
+		if (Ranges.Num() > 0 && Ranges.Last().Name == Tag.Name)
+		{
+			Ranges.Last().End = End;
+		}
+		else
+		{
+			Ranges.Add({Tag.Name, Start, End});
+		}
+	}
+
+	return false;
+}
+
+/** Compress save data, profiling it */
+static bool CompressSaveData(FName CodecName, void* CompressedData, int32& CompressedSize, const void* RawData, int32 RawSize)
+{
+	NEUTRON_SAVE_SCOPE(Compress);
+
+	return FCompression::CompressMemory(CodecName, CompressedData, CompressedSize, RawData, RawSize);
+}
 
-		// Allocate a buffer
-		uint8* CompressedData         = new uint8[FullCompressedSize];
-		uint8* CompressedDataContents = CompressedData + 4;
+/** Uncompress save data, profiling it */
+static bool UncompressSaveData(FName CodecName, void* RawData, int32 RawSize, const void* CompressedData, int32 CompressedSize)
+{
+	NEUTRON_SAVE_SCOPE(Inflate);
+
+	return FCompression::UncompressMemory(CodecName, RawData, RawSize, CompressedData, CompressedSize);
+}
+
+/*----------------------------------------------------
+    Save file archives
+----------------------------------------------------*/
+
+/** File writer that checksums written data and can durably commit it to disk */
+class FNeutronSaveFileWriter : public FArchive
+{
+public:
+
+	FNeutronSaveFileWriter(IFileHandle* HandleParam) : Handle(HandleParam), Checksum(0)
+	{
+		SetIsSaving(true);
+		SetIsPersistent(true);
+	}
 
-		// Write size
-		CompressedData[0] = (DataSize >> 24) & 0xFF;
-		CompressedData[1] = (DataSize >> 16) & 0xFF;
-		CompressedData[2] = (DataSize >> 8) & 0xFF;
-		CompressedData[3] = (DataSize >> 0) & 0xFF;
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		NEUTRON_SAVE_SCOPE(Write);
 
-		// Compress contents
-		if (FCompression::CompressMemory(NAME_Zlib, CompressedDataContents, ContentsCompressedSize, TCHAR_TO_UTF8(*FileContents), DataSize))
+		if (Handle->Write(static_cast<const uint8*>(Data), Num))
 		{
-			int32 EffectiveCompressedSize = ContentsCompressedSize + 4;
-			Result                        = FFileHelper::SaveArrayToFile(
-									   TArrayView<const uint8>(CompressedData, EffectiveCompressedSize), *GetSaveGamePath(SaveName, true));
+			Checksum = FCrc::MemCrc32(Data, static_cast<int32>(Num), Checksum);
 		}
 		else
 		{
-			NERR("UNeutronSaveManager::SaveGame : failed to compress data");
+			SetError();
+		}
+	}
+
+	virtual void Seek(int64 Position) override
+	{
+		if (!Handle->Seek(Position))
+		{
+			SetError();
 		}
+	}
 
-		delete[] CompressedData;
+	virtual int64 Tell() override
+	{
+		return Handle->Tell();
 	}
-	else
+
+	virtual int64 TotalSize() override
 	{
-		Result = FFileHelper::SaveStringToFile(FileContents, *GetSaveGamePath(SaveName, false));
+		return Handle->Size();
 	}
 
-	NLOG("UNeutronSaveManager::SaveGame : done with result %d", Result);
+	virtual FString GetArchiveName() const override
+	{
+		return TEXT("FNeutronSaveFileWriter");
+	}
 
-	SaveLock.Unlock();
+	/** Flush all data to the storage device */
+	bool Commit()
+	{
+		NEUTRON_SAVE_SCOPE(Write);
 
-	// Pop the request from the list
-	SaveListLock.Lock();
-	SaveList.Remove(JsonData);
-	SaveListLock.Unlock();
+		return Handle->Flush(true) && !IsError();
+	}
 
-	return Result;
-}
+	/** Restart the checksum from the current position */
+	void ResetChecksum()
+	{
+		Checksum = 0;
+	}
 
-TSharedPtr<FJsonObject> UNeutronSaveManager::LoadGameInternal(const FString SaveName)
+	/** Get the checksum of data written since the last reset */
+	uint32 GetChecksum() const
+	{
+		return Checksum;
+	}
+
+protected:
+
+	TUniquePtr<IFileHandle> Handle;
+	uint32                  Checksum;
+};
+
+/** Reader proxy that checksums the data going through it */
+class FNeutronChecksumReader : public FArchiveProxy
 {
-	FString SaveString;
-	bool    SaveStringLoaded = false;
+public:
+
+	FNeutronChecksumReader(FArchive& InnerArchive) : FArchiveProxy(InnerArchive), Checksum(0)
+	{}
 
-	if (DoesSaveExist(SaveName))
+	virtual void Serialize(void* Data, int64 Num) override
 	{
-		NLOG("UNeutronSaveManager::LoadGameInternal : loading from '%s'", *SaveName);
+		InnerArchive.Serialize(Data, Num);
+		Checksum = FCrc::MemCrc32(Data, static_cast<int32>(Num), Checksum);
+	}
 
-		TArray<uint8> Data;
+	/** Get the checksum of data read so far */
+	uint32 GetChecksum() const
+	{
+		return Checksum;
+	}
 
-		auto LoadCompressedFileToString = [&](FString& Result, const TCHAR* Filename)
-		{
-			TArray<uint8> CompressedData;
-			if (!FFileHelper::LoadFileToArray(CompressedData, Filename))
-			{
-				NLOG("UNeutronSaveManager::LoadGameInternal : no compressed save file found");
-				return false;
-			}
+protected:
 
-			// Read uncompressed size
-			int32 UncompressedSize = (CompressedData[0] << 24) + (CompressedData[1] << 16) + (CompressedData[2] << 8) + CompressedData[3];
-			Data.SetNum(UncompressedSize + 1);
+	uint32 Checksum;
+};
 
-			// Uncompress
-			if (!FCompression::UncompressMemory(
-					NAME_Zlib, Data.GetData(), UncompressedSize, CompressedData.GetData() + 4, CompressedData.Num() - 4))
-			{
-				NERR("UNeutronSaveManager::LoadGameInternal : failed to uncompress with compressed size %d and uncompressed size %d",
-					CompressedData.Num(), UncompressedSize);
-				return false;
-			}
+/*----------------------------------------------------
+    Compressed block writer
+----------------------------------------------------*/
 
-			// Convert to string
-			Data[UncompressedSize] = 0;
-			Result                 = UTF8_TO_TCHAR(Data.GetData());
-			return true;
-		};
+/** Archive that compresses data into independent blocks as it is written, and flushes them to a file */
+class FNeutronCompressedWriter : public FArchive
+{
+public:
+
+	FNeutronCompressedWriter(FArchive& InnerArchive, FName Codec, int32 BlockSizeParam)
+		: Inner(InnerArchive), CodecName(Codec), BlockSize(BlockSizeParam), UncompressedSize(0)
+	{
+		SetIsSaving(true);
+		SetIsPersistent(true);
 
-		// Check which file to load
-		if (LoadCompressedFileToString(SaveString, *GetSaveGamePath(SaveName, true)))
+		RawBlock.Reserve(BlockSize);
+		if (CodecName != NAME_None)
 		{
-			NLOG("UNeutronSaveManager::LoadGame : read '%s'", *GetSaveGamePath(SaveName, true));
-			SaveStringLoaded = true;
+			CompressedBlock.SetNumUninitialized(FCompression::CompressMemoryBound(CodecName, BlockSize));
 		}
-		else if (FFileHelper::LoadFileToString(SaveString, *GetSaveGamePath(SaveName, false)))
+	}
+
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		const uint8* Source = static_cast<const uint8*>(Data);
+
+		while (Num > 0 && !IsError())
 		{
-			NLOG("UNeutronSaveManager::LoadGame : read '%s'", *GetSaveGamePath(SaveName, false));
-			SaveStringLoaded = true;
+			int64 CopySize = FMath::Min(Num, static_cast<int64>(BlockSize - RawBlock.Num()));
+			RawBlock.Append(Source, CopySize);
+			UncompressedSize += CopySize;
+			Source += CopySize;
+			Num -= CopySize;
+
+			if (RawBlock.Num() == BlockSize)
+			{
+				FlushBlock();
+			}
 		}
 	}
 
-	// Get JSON data from the save string
-	TSharedPtr<FJsonObject> JsonData;
-	if (SaveStringLoaded)
+	virtual FString GetArchiveName() const override
 	{
-		return StringToJson(SaveString);
+		return TEXT("FNeutronCompressedWriter");
 	}
-	else
+
+	/** Write the last partial block */
+	bool Finalize()
 	{
-		NLOG("UNeutronSaveManager::LoadGame : failed to read either '%s' or '%s'", *GetSaveGamePath(SaveName, true),
-			*GetSaveGamePath(SaveName, false));
+		FlushBlock();
 
-		return MakeShared<FJsonObject>();
+		return !IsError() && !Inner.IsError();
 	}
-}
+
+	/** Get the total amount of data written so far */
+	int64 GetUncompressedSize() const
+	{
+		return UncompressedSize;
+	}
+
+protected:
+
+	/** Compress the current block and write it with its compressed and uncompressed sizes */
+	void FlushBlock()
+	{
+		if (RawBlock.Num() == 0)
+		{
+			return;
+		}
+
+		if (CodecName == NAME_None)
+		{
+			Inner.Serialize(RawBlock.GetData(), RawBlock.Num());
+		}
+		else
+		{
+			int32 CompressedSize = CompressedBlock.Num();
+			if (CompressSaveData(CodecName, CompressedBlock.GetData(), CompressedSize, RawBlock.GetData(), RawBlock.Num()))
+			{
+				int32 RawSize = RawBlock.Num();
+				Inner << CompressedSize;
+				Inner << RawSize;
+				Inner.Serialize(CompressedBlock.GetData(), CompressedSize);
+			}
+			else
+			{
+				NERR("FNeutronCompressedWriter::FlushBlock : failed to compress data with '%s'", *CodecName.ToString());
+				SetError();
+			}
+		}
+
+		RawBlock.Reset();
+	}
+
+	FArchive&     Inner;
+	FName         CodecName;
+	int32         BlockSize;
+	TArray<uint8> RawBlock;
+	TArray<uint8> CompressedBlock;
+	int64         UncompressedSize;
+};
 
 /*----------------------------------------------------
-    Helpers
+    Asynchronous task
 ----------------------------------------------------*/
 
-FString UNeutronSaveManager::GetSaveGamePath(const FString SaveName, bool Compressed)
+class FNeutronAsyncSave : public FNonAbandonableTask
 {
-	if (Compressed)
+	friend class FAutoDeleteAsyncTask<FNeutronAsyncSave>;
+
+public:
+
+	FNeutronAsyncSave(UNeutronSaveManager* SaveSystemParam, const FString SaveNameParam)
+		: SaveName(SaveNameParam), SaveSystem(SaveSystemParam)
+	{}
+
+protected:
+
+	void DoWork()
 	{
-		return FString::Printf(TEXT("%s/%s.sav"), *FPaths::ProjectSavedDir(), *SaveName);
+		NLOG("FNeutronAsyncSave::DoWork : started");
+
+		SaveSystem->ProcessSaveQueue(SaveName);
+
+		NLOG("FNeutronAsyncSave::DoWork : done");
 	}
-	else
+
+	FORCEINLINE TStatId GetStatId() const
 	{
-		return FString::Printf(TEXT("%s/%s.json"), *FPaths::ProjectSavedDir(), *SaveName);
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FNeutronAsyncSave, STATGROUP_ThreadPoolAsyncTasks);
 	}
+
+protected:
+
+	FString              SaveName;
+	UNeutronSaveManager* SaveSystem;
+};
+
+/*----------------------------------------------------
+    Constructor
+----------------------------------------------------*/
+
+UNeutronSaveManager::UNeutronSaveManager()
+	: Super()
+	, CurrentSaveData(nullptr)
+	, TimeOfLastSave(0)
+	, PendingLoadCount(0)
+	, SaveFormat(ENeutronSaveFormat::Json)
+	, SaveCodec(ENeutronSaveCodec::Zlib)
+	, BackupCount(2)
+	, IncrementalSaves(false)
+	, SaveIndexLoaded(false)
+{}
+
+/*----------------------------------------------------
+    Interface
+----------------------------------------------------*/
+
+bool UNeutronSaveManager::DoesSaveExist(const FString SaveName)
+{
+	// The index follows saves and deletions, so files are only checked for saves written without it
+	SaveIndexLock.Lock();
+	LoadSaveIndex();
+	bool Exists = SaveIndex.Contains(SaveName);
+	SaveIndexLock.Unlock();
+
+	return Exists || GetSaveCandidates(SaveName).Num() > 0;
+}
+
+bool UNeutronSaveManager::DeleteGame(const FString SaveName)
+{
+	// Delete the save in both formats, along with temporary files and backups
+	bool Result = false;
+	for (const TPair<FString, bool>& Candidate : GetSaveCandidates(SaveName))
+	{
+		Result |= IFileManager::Get().Delete(*Candidate.Key, false, false, true);
+	}
+
+	SaveLock.Lock();
+	IFileManager::Get().Delete(*GetSaveJournalPath(SaveName), false, false, true);
+	JournalStates.Remove(SaveName);
+	SaveLock.Unlock();
+
+	SaveIndexLock.Lock();
+	LoadSaveIndex();
+	if (SaveIndex.Remove(SaveName) > 0)
+	{
+		WriteSaveIndex();
+	}
+	SaveIndexLock.Unlock();
+
+	return Result;
+}
+
+TArray<FNeutronSaveSlotInfo> UNeutronSaveManager::EnumerateSaves()
+{
+	TArray<FNeutronSaveSlotInfo> Saves;
+
+	SaveIndexLock.Lock();
+	LoadSaveIndex();
+	SaveIndex.GenerateValueArray(Saves);
+	SaveIndexLock.Unlock();
+
+	Saves.Sort(
+		[](const FNeutronSaveSlotInfo& A, const FNeutronSaveSlotInfo& B)
+		{
+			return A.Timestamp > B.Timestamp;
+		});
+
+	return Saves;
+}
+
+void UNeutronSaveManager::SetSaveSummary(const FString SaveName, const TMap<FString, FString>& Summary, const TArray<uint8>& Thumbnail)
+{
+	SaveIndexLock.Lock();
+	FNeutronSaveSlotInfo& Info = PendingSaveSummaries.FindOrAdd(SaveName);
+	Info.Summary               = Summary;
+	Info.Thumbnail             = Thumbnail;
+	SaveIndexLock.Unlock();
+}
+
+/*----------------------------------------------------
+    Internals
+----------------------------------------------------*/
+
+void UNeutronSaveManager::SaveGameAsync(const FString SaveName, const UScriptStruct* Struct,
+	TSharedPtr<FNeutronSaveDataBase> SaveDataOwner, const void* SaveData, bool Compress)
+{
+	NCHECK(SaveDataOwner.IsValid());
+
+	FNeutronSaveRequest Request;
+	Request.Struct        = Struct;
+	Request.SaveDataOwner = SaveDataOwner;
+	Request.SaveData      = SaveData;
+	Request.Compress      = Compress;
+	Request.QueueTime     = FPlatformTime::Seconds();
+
+	SaveQueueLock.Lock();
+
+	FNeutronSaveSlotQueue& Queue = SaveQueues.FindOrAdd(SaveName);
+
+	// Replace a save that wasn't started yet
+	if (Queue.PendingRequest.IsSet())
+	{
+		NLOG("UNeutronSaveManager::SaveGameAsync : replacing pending save to '%s'", *SaveName);
+		SaveQueueStats.CoalescedCount++;
+	}
+	else
+	{
+		SaveQueueStats.QueueDepth++;
+	}
+	Queue.PendingRequest = Request;
+
+	// Start writing unless a writer is already running for this slot, in which case it will pick the request up
+	bool StartWriter = !Queue.Writing;
+	Queue.Writing    = true;
+
+	SaveQueueLock.Unlock();
+
+	if (StartWriter)
+	{
+		(new FAutoDeleteAsyncTask<FNeutronAsyncSave>(this, SaveName))->StartBackgroundTask();
+	}
+}
+
+void UNeutronSaveManager::ProcessSaveQueue(const FString SaveName)
+{
+	while (true)
+	{
+		SaveQueueLock.Lock();
+		FNeutronSaveSlotQueue& Queue = SaveQueues.FindChecked(SaveName);
+
+		// Write the pending save first, so that loads see the saves queued before them
+		if (Queue.PendingRequest.IsSet())
+		{
+			FNeutronSaveRequest Request = Queue.PendingRequest.GetValue();
+			Queue.PendingRequest.Reset();
+			SaveQueueLock.Unlock();
+
+			// Write
+			SaveGame(SaveName, Request.Struct, Request.SaveData, Request.Compress);
+			double Latency = FPlatformTime::Seconds() - Request.QueueTime;
+
+			// Update statistics
+			SaveQueueLock.Lock();
+			SaveQueueStats.QueueDepth--;
+			SaveQueueStats.WrittenCount++;
+			SaveQueueStats.LastWriteLatency = Latency;
+			SaveQueueStats.MaxWriteLatency  = FMath::Max(SaveQueueStats.MaxWriteLatency, Latency);
+			SaveQueueLock.Unlock();
+
+			NLOG("UNeutronSaveManager::ProcessSaveQueue : wrote '%s' in %.3fs", *SaveName, Latency);
+		}
+
+		// Then run loads in order
+		else if (Queue.PendingLoads.Num() > 0)
+		{
+			FNeutronLoadRequest Request = Queue.PendingLoads[0];
+			Queue.PendingLoads.RemoveAt(0);
+			SaveQueueLock.Unlock();
+
+			bool Success = LoadGameInternal(SaveName, Request.Struct, Request.SaveData);
+
+			// Hand the data over to the game thread
+			AsyncTask(ENamedThreads::GameThread,
+				[Request, Success]()
+				{
+					if (Request.SaveSystem.IsValid())
+					{
+						Request.SaveSystem->PendingLoadCount--;
+						Request.Callback.ExecuteIfBound(Success);
+					}
+				});
+
+			NLOG("UNeutronSaveManager::ProcessSaveQueue : loaded '%s' with result %d", *SaveName, Success);
+		}
+
+		// Stop when there is nothing left
+		else
+		{
+			Queue.Writing = false;
+			SaveQueueLock.Unlock();
+			return;
+		}
+	}
+}
+
+void UNeutronSaveManager::FlushPendingSaves()
+{
+	NLOG("UNeutronSaveManager::FlushPendingSaves");
+
+	while (true)
+	{
+		SaveQueueLock.Lock();
+		bool Writing = false;
+		for (const TPair<FString, FNeutronSaveSlotQueue>& Entry : SaveQueues)
+		{
+			Writing |= Entry.Value.Writing;
+		}
+		SaveQueueLock.Unlock();
+
+		if (!Writing)
+		{
+			break;
+		}
+
+		FPlatformProcess::Sleep(0.01f);
+	}
+}
+
+FNeutronSaveQueueStats UNeutronSaveManager::GetSaveQueueStats()
+{
+	SaveQueueLock.Lock();
+	FNeutronSaveQueueStats Stats = SaveQueueStats;
+	SaveQueueLock.Unlock();
+
+	return Stats;
+}
+
+bool UNeutronSaveManager::SaveGame(const FString SaveName, const UScriptStruct* Struct, const void* SaveData, bool Compress)
+{
+	return SaveGame(SaveName, Struct, SaveData, SaveFormat, Compress ? SaveCodec : ENeutronSaveCodec::None);
+}
+
+bool UNeutronSaveManager::SaveGame(
+	const FString SaveName, const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, ENeutronSaveCodec Codec)
+{
+	NLOG("UNeutronSaveManager::SaveGame : saving to '%s' with format %d", *SaveName, static_cast<int32>(Format));
+
+	NCHECK(Struct);
+	NCHECK(SaveData);
+
+	SaveLock.Lock();
+
+	NeutronSaveProfile = FNeutronSaveProfile();
+	bool Result        = false;
+
+	// Incremental saves only append the changed sections to the journal of the previous save
+	bool Compress = Codec != ENeutronSaveCodec::None;
+	if (IncrementalSaves && Compress && Format == SaveFormat && WriteSaveJournal(SaveName, Struct, SaveData))
+	{
+		Result = true;
+	}
+
+	// Uncompressed JSON saves are written as plain text
+	else if (Format == ENeutronSaveFormat::Json && !Compress)
+	{
+		Result = WriteSaveTextFile(GetSaveGamePath(SaveName, false, true), Struct, SaveData, GetSchemaVersion(Struct));
+		Result = Result && CommitSaveFile(SaveName, false);
+	}
+
+	// Other saves get a header followed by the payload, compressed as it is serialized
+	else
+	{
+		Result = WriteSaveFile(GetSaveGamePath(SaveName, true, true), Struct, SaveData, Format, Codec, GetSchemaVersion(Struct));
+		Result = Result && CommitSaveFile(SaveName, true);
+
+		// Start a new journal on top of the full save
+		if (Result)
+		{
+			ResetSaveJournal(SaveName, Struct, SaveData, Format);
+		}
+	}
+
+	if (Result)
+	{
+		UpdateSaveIndex(SaveName, Format != ENeutronSaveFormat::Json || Compress, Struct, GetSchemaVersion(Struct));
+	}
+
+	PublishSaveProfile();
+
+	NLOG("UNeutronSaveManager::SaveGame : done with result %d", Result);
+
+	SaveLock.Unlock();
+
+	return Result;
+}
+
+void UNeutronSaveManager::LoadGameAsync(const FString SaveName, const UScriptStruct* Struct,
+	TSharedPtr<FNeutronSaveDataBase> SaveDataOwner, void* SaveData, FNeutronAsyncLoadCallback Callback)
+{
+	NLOG("UNeutronSaveManager::LoadGameAsync : loading '%s'", *SaveName);
+
+	NCHECK(IsInGameThread());
+	NCHECK(SaveDataOwner.IsValid());
+
+	FNeutronLoadRequest Request;
+	Request.Struct        = Struct;
+	Request.SaveDataOwner = SaveDataOwner;
+	Request.SaveData      = SaveData;
+	Request.Callback      = Callback;
+	Request.SaveSystem    = this;
+
+	PendingLoadCount++;
+
+	// Queue the load behind saves to the same slot, starting the slot worker unless it is already running
+	SaveQueueLock.Lock();
+	FNeutronSaveSlotQueue& Queue = SaveQueues.FindOrAdd(SaveName);
+	Queue.PendingLoads.Add(Request);
+	bool StartWorker = !Queue.Writing;
+	Queue.Writing    = true;
+	SaveQueueLock.Unlock();
+
+	if (StartWorker)
+	{
+		(new FAutoDeleteAsyncTask<FNeutronAsyncSave>(this, SaveName))->StartBackgroundTask();
+	}
+}
+
+bool UNeutronSaveManager::LoadGameInternal(
+	const FString SaveName, const UScriptStruct* Struct, void* SaveData, ENeutronSaveFormat* LoadedFormat, ENeutronSaveCodec* LoadedCodec)
+{
+	NCHECK(Struct);
+	NCHECK(SaveData);
+
+	// The next incremental save will need a full save to know the on-disk state
+	SaveLock.Lock();
+	JournalStates.Remove(SaveName);
+	SaveLock.Unlock();
+
+	// Profile the load, reading being anything that isn't inflating or parsing
+	NeutronSaveProfile = FNeutronSaveProfile();
+	ON_SCOPE_EXIT
+	{
+		PublishLoadProfile();
+	};
+	NEUTRON_SAVE_SCOPE(Read);
+
+	// Try the save, then the temporary file of an interrupted save, then backups from newest to oldest
+	for (const TPair<FString, bool>& Candidate : GetSaveCandidates(SaveName))
+	{
+		const FString&     Filename = Candidate.Key;
+		TArray<uint8>      Payload;
+		ENeutronSaveFormat Format        = ENeutronSaveFormat::Json;
+		ENeutronSaveCodec  Codec         = ENeutronSaveCodec::None;
+		uint32             SchemaVersion = 0;
+
+		bool Result = Candidate.Value ? ReadSaveFile(Filename, Format, Codec, Payload, SchemaVersion) : ReadSaveTextFile(Filename, Payload);
+
+		// The journal is written on top of the save itself, and is folded into it before migrating it
+		FNeutronSaveJournal Journal;
+		bool                Journaled = Result && Filename == GetSaveGamePath(SaveName, true) && ReadSaveJournal(SaveName, Journal);
+		if (Journaled && (Journal.Format != Format || Journal.SchemaVersion != SchemaVersion))
+		{
+			NERR("UNeutronSaveManager::LoadGameInternal : journal for '%s' doesn't match its save", *SaveName);
+			Journaled = false;
+		}
+
+		if (Result && DeserializeSaveData(Struct, SaveData, Format, Payload, SchemaVersion, Journaled ? &Journal : nullptr))
+		{
+			NLOG("UNeutronSaveManager::LoadGameInternal : read '%s'", *Filename);
+
+			if (LoadedFormat)
+			{
+				*LoadedFormat = Format;
+			}
+			if (LoadedCodec)
+			{
+				*LoadedCodec = Codec;
+			}
+
+			return true;
+		}
+
+		// Start over from default data with the next file
+		NERR("UNeutronSaveManager::LoadGameInternal : failed to read '%s'", *Filename);
+		Struct->ClearScriptStruct(SaveData);
+	}
+
+	NLOG("UNeutronSaveManager::LoadGameInternal : no valid save for '%s'", *SaveName);
+
+	return false;
+}
+
+TArray<TPair<FString, bool>> UNeutronSaveManager::GetSaveCandidates(const FString SaveName) const
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	// Find the files of a format, and when the newest one was written
+	auto FindFiles = [&](bool Compressed, FDateTime& NewestTimestamp)
+	{
+		TArray<FString> Paths = {GetSaveGamePath(SaveName, Compressed), GetSaveGamePath(SaveName, Compressed, true)};
+		for (int32 Index = 1; Index <= BackupCount; Index++)
+		{
+			Paths.Add(GetSaveBackupPath(SaveName, Compressed, Index));
+		}
+
+		TArray<TPair<FString, bool>> Files;
+		NewestTimestamp = FDateTime::MinValue();
+		for (const FString& Path : Paths)
+		{
+			FDateTime Timestamp = FileManager.GetTimeStamp(*Path);
+			if (Timestamp != FDateTime::MinValue())
+			{
+				Files.Add(TPair<FString, bool>(Path, Compressed));
+				NewestTimestamp = FMath::Max(NewestTimestamp, Timestamp);
+			}
+		}
+
+		return Files;
+	};
+
+	FDateTime                    CompressedTimestamp;
+	FDateTime                    TextTimestamp;
+	TArray<TPair<FString, bool>> Candidates     = FindFiles(true, CompressedTimestamp);
+	TArray<TPair<FString, bool>> TextCandidates = FindFiles(false, TextTimestamp);
+
+	// A save left in the other format by an earlier session is only used once all files of the newest format failed
+	if (TextTimestamp > CompressedTimestamp)
+	{
+		Swap(Candidates, TextCandidates);
+	}
+	Candidates.Append(TextCandidates);
+
+	return Candidates;
+}
+
+bool UNeutronSaveManager::SerializeSaveData(
+	const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, FArchive& Archive)
+{
+	// Write JSON as UTF-8 text, streamed into the archive one section at a time
+	if (Format == ENeutronSaveFormat::Json)
+	{
+		auto JsonWriter = TJsonWriterFactory<UTF8CHAR, TCondensedJsonPrintPolicy<UTF8CHAR>>::Create(&Archive);
+		JsonWriter->WriteObjectStart();
+		if (!WriteSaveJsonFields(Struct, SaveData, JsonWriter))
+		{
+			return false;
+		}
+		JsonWriter->WriteObjectEnd();
+		JsonWriter->Close();
+	}
+
+	// Write binary data as versioned tagged properties, straight from reflection data
+	else
+	{
+		WriteSaveVersions(Archive);
+
+		FObjectAndNameAsStringProxyArchive ProxyArchive(Archive, false);
+		const_cast<UScriptStruct*>(Struct)->SerializeItem(ProxyArchive, const_cast<void*>(SaveData), nullptr);
+	}
+
+	return !Archive.IsError();
+}
+
+bool UNeutronSaveManager::DeserializeSaveData(const UScriptStruct* Struct, void* SaveData, ENeutronSaveFormat Format,
+	TArray<uint8>& Payload, uint32 SchemaVersion, const FNeutronSaveJournal* Journal) const
+{
+	NEUTRON_SAVE_SCOPE(Parse);
+
+	// Read JSON from UTF-8 text
+	if (Format == ENeutronSaveFormat::Json)
+	{
+		FUTF8ToTCHAR            Converter(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+		TSharedPtr<FJsonObject> JsonData = ParseSaveJson(FString(Converter.Length(), Converter.Get()));
+
+		// Plain JSON saves hold their schema version as a field
+		int32 JsonSchemaVersion = 0;
+		if (JsonData.IsValid() && JsonData->TryGetNumberField(NeutronJsonSchemaVersionField, JsonSchemaVersion))
+		{
+			SchemaVersion = FMath::Max(JsonSchemaVersion, 0);
+		}
+
+		return JsonData.IsValid() && (Journal == nullptr || FoldSaveJournal(*Journal, JsonData, Payload)) &&
+		       MigrateSaveData(Struct, SchemaVersion, JsonData, Payload) &&
+		       FJsonObjectConverter::JsonObjectToUStruct(JsonData.ToSharedRef(), Struct, SaveData);
+	}
+
+	// Read binary data with the versions it was written with
+	else if (Format == ENeutronSaveFormat::Binary)
+	{
+		// Journals written before sections were tagged can't be folded, and are applied once deserialized instead
+		bool Tagged = Journal == nullptr || Journal->Version >= NeutronJournalVersionTagged;
+		if (Journal && Tagged && !FoldSaveJournal(*Journal, nullptr, Payload))
+		{
+			return false;
+		}
+		else if (!MigrateSaveData(Struct, SchemaVersion, nullptr, Payload))
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(Payload, true);
+		ReadSaveVersions(Reader);
+		if (Reader.IsError())
+		{
+			return false;
+		}
+
+		FObjectAndNameAsStringProxyArchive Archive(Reader, true);
+		const_cast<UScriptStruct*>(Struct)->SerializeItem(Archive, SaveData, nullptr);
+		if (Reader.IsError())
+		{
+			return false;
+		}
+
+		// Untagged sections only match the schema they were written with
+		if (!Tagged && SchemaVersion != GetSchemaVersion(Struct))
+		{
+			NERR("UNeutronSaveManager::DeserializeSaveData : untagged journal can't be upgraded from schema version %d", SchemaVersion);
+		}
+		else if (!Tagged)
+		{
+			for (const FNeutronSaveJournalSection& Section : Journal->Sections)
+			{
+				FProperty* Property = Struct->FindPropertyByName(FName(*Section.Name));
+				if (Property && Property->GetCPPType() == Section.Type)
+				{
+					TArray<uint8> SectionData = Journal->VersionData;
+					SectionData.Append(Section.Data);
+
+					FMemoryReader SectionReader(SectionData, true);
+					ReadSaveVersions(SectionReader);
+					DeserializeSaveSection(Property, SaveData, SectionReader);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	NERR("UNeutronSaveManager::DeserializeSaveData : unknown format %d", static_cast<int32>(Format));
+
+	return false;
+}
+
+bool UNeutronSaveManager::MigrateSaveData(
+	const UScriptStruct* Struct, uint32 SchemaVersion, const TSharedPtr<FJsonObject>& JsonData, TArray<uint8>& Payload) const
+{
+	const TArray<FNeutronSaveMigration>* Migrations     = SaveMigrations.Find(Struct);
+	uint32                               CurrentVersion = GetSchemaVersion(Struct);
+
+	if (SchemaVersion > CurrentVersion)
+	{
+		NERR("UNeutronSaveManager::MigrateSaveData : save has schema version %d, newer than %d", SchemaVersion, CurrentVersion);
+		return false;
+	}
+
+	// Upgrade one version at a time
+	for (uint32 Version = SchemaVersion; Version < CurrentVersion; Version++)
+	{
+		const FNeutronSaveMigration& Migration = (*Migrations)[Version];
+
+		bool Result;
+		if (JsonData.IsValid())
+		{
+			Result = Migration.Json && Migration.Json(JsonData.ToSharedRef());
+		}
+		else
+		{
+			Result = Migration.Binary && Migration.Binary(Payload);
+		}
+
+		if (!Result)
+		{
+			NERR("UNeutronSaveManager::MigrateSaveData : failed to upgrade from schema version %d", Version);
+			return false;
+		}
+	}
+
+	if (SchemaVersion < CurrentVersion)
+	{
+		NLOG("UNeutronSaveManager::MigrateSaveData : upgraded from schema version %d to %d", SchemaVersion, CurrentVersion);
+	}
+
+	return true;
+}
+
+bool UNeutronSaveManager::CommitSaveFile(const FString SaveName, bool Compressed)
+{
+	NEUTRON_SAVE_SCOPE(Write);
+
+	IFileManager& FileManager = IFileManager::Get();
+	FString       SavePath    = GetSaveGamePath(SaveName, Compressed);
+
+	// Rotate backups, dropping the oldest one
+	if (BackupCount > 0 && FileManager.FileSize(*SavePath) >= 0)
+	{
+		FileManager.Delete(*GetSaveBackupPath(SaveName, Compressed, BackupCount), false, false, true);
+		for (int32 Index = BackupCount - 1; Index >= 1; Index--)
+		{
+			FString BackupPath = GetSaveBackupPath(SaveName, Compressed, Index);
+			if (FileManager.FileSize(*BackupPath) >= 0)
+			{
+				FileManager.Move(*GetSaveBackupPath(SaveName, Compressed, Index + 1), *BackupPath, true, true, false, true);
+			}
+		}
+
+		if (!FileManager.Move(*GetSaveBackupPath(SaveName, Compressed, 1), *SavePath, true, true, false, true))
+		{
+			NERR("UNeutronSaveManager::CommitSaveFile : failed to back up '%s'", *SavePath);
+		}
+	}
+
+	// Replace the save with the fully written temporary file, which loading uses if this gets interrupted after deleting the save
+	if (!FileManager.Move(*SavePath, *GetSaveGamePath(SaveName, Compressed, true), true, true, false, true))
+	{
+		NERR("UNeutronSaveManager::CommitSaveFile : failed to write '%s'", *SavePath);
+		return false;
+	}
+
+	return true;
+}
+
+bool UNeutronSaveManager::WriteSaveFile(const FString& Filename, const UScriptStruct* Struct, const void* SaveData,
+	ENeutronSaveFormat Format, ENeutronSaveCodec Codec, uint32 SchemaVersion)
+{
+	NEUTRON_SAVE_SCOPE(Serialize);
+
+	IFileHandle* Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename);
+	if (Handle == nullptr)
+	{
+		NERR("UNeutronSaveManager::WriteSaveFile : failed to open '%s'", *Filename);
+		return false;
+	}
+	FNeutronSaveFileWriter FileWriter(Handle);
+
+	// Write a header, the final size is patched in when done
+	FNeutronSaveHeader Header;
+	Header.Format        = static_cast<uint8>(Format);
+	Header.Codec         = static_cast<uint8>(Codec);
+	Header.SchemaVersion = SchemaVersion;
+	Header.StructPath    = Struct->GetPathName();
+	FileWriter << Header;
+	FileWriter.ResetChecksum();
+
+	// Serialize straight into the compressor
+	FNeutronCompressedWriter CompressedWriter(FileWriter, GetCodecName(Codec), Header.BlockSize);
+	if (!SerializeSaveData(Struct, SaveData, Format, CompressedWriter) || !CompressedWriter.Finalize())
+	{
+		NERR("UNeutronSaveManager::WriteSaveFile : failed to serialize data");
+		return false;
+	}
+
+	// Never commit a payload that loading would reject, or whose size doesn't fit the header
+	if (CompressedWriter.GetUncompressedSize() > NeutronSaveMaxSize)
+	{
+		NERR("UNeutronSaveManager::WriteSaveFile : payload of %lld bytes is over the %u bytes limit",
+			CompressedWriter.GetUncompressedSize(), NeutronSaveMaxSize);
+		return false;
+	}
+	int64 FooterOffset = FileWriter.Tell();
+
+	// Patch the header, which ends the checksummed data
+	Header.UncompressedSize = CompressedWriter.GetUncompressedSize();
+	FileWriter.Seek(0);
+	FileWriter << Header;
+
+	// Write the checksum footer
+	uint32 Checksum = FileWriter.GetChecksum();
+	FileWriter.Seek(FooterOffset);
+	FileWriter << Checksum;
+
+	NeutronSaveProfile.RawSize        = Header.UncompressedSize;
+	NeutronSaveProfile.CompressedSize = FileWriter.TotalSize();
+
+	return FileWriter.Commit();
+}
+
+bool UNeutronSaveManager::ReadSaveFile(
+	const FString& Filename, ENeutronSaveFormat& Format, ENeutronSaveCodec& Codec, TArray<uint8>& Payload, uint32& SchemaVersion)
+{
+	NEUTRON_SAVE_SCOPE(Read);
+
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!FileReader.IsValid())
+	{
+		NLOG("UNeutronSaveManager::ReadSaveFile : no compressed save file found");
+		return false;
+	}
+	FNeutronChecksumReader Reader(*FileReader);
+
+	// Read the header, or the uncompressed size for legacy saves, which are a single compressed JSON buffer
+	FNeutronSaveHeader Header;
+	*FileReader << Header;
+	if (Header.Magic != NeutronSaveMagic)
+	{
+		uint8 SizeBytes[4] = {0, 0, 0, 0};
+		FileReader->ClearError();
+		FileReader->Seek(0);
+		FileReader->Serialize(SizeBytes, 4);
+
+		Header.Version          = 0;
+		Header.SchemaVersion    = 0;
+		Header.Format           = static_cast<uint8>(ENeutronSaveFormat::Json);
+		Header.Codec            = static_cast<uint8>(ENeutronSaveCodec::Zlib);
+		Header.UncompressedSize = (static_cast<uint32>(SizeBytes[0]) << 24) | (static_cast<uint32>(SizeBytes[1]) << 16) |
+		                          (static_cast<uint32>(SizeBytes[2]) << 8) | static_cast<uint32>(SizeBytes[3]);
+	}
+	Format        = static_cast<ENeutronSaveFormat>(Header.Format);
+	Codec         = static_cast<ENeutronSaveCodec>(Header.Codec);
+	SchemaVersion = Header.SchemaVersion;
+
+	NeutronSaveProfile.RawSize        = Header.UncompressedSize;
+	NeutronSaveProfile.CompressedSize = FileReader->TotalSize();
+
+	// Reject damaged or truncated headers before allocating anything from them
+	FName CodecName     = GetCodecName(static_cast<ENeutronSaveCodec>(Header.Codec));
+	int64 RemainingSize = FileReader->TotalSize() - FileReader->Tell();
+	if (FileReader->IsError() || Header.Version > NeutronSaveVersion || Header.Format > static_cast<uint8>(ENeutronSaveFormat::Binary) ||
+		Header.Codec > static_cast<uint8>(ENeutronSaveCodec::LZ4) || Header.BlockSize <= 0 ||
+		Header.UncompressedSize > NeutronSaveMaxSize || RemainingSize <= 0 ||
+		(CodecName == NAME_None && Header.UncompressedSize > RemainingSize))
+	{
+		NERR("UNeutronSaveManager::ReadSaveFile : invalid header in '%s'", *Filename);
+		return false;
+	}
+
+	Payload.SetNumUninitialized(Header.UncompressedSize);
+
+	// Uncompressed data is stored as-is
+	if (CodecName == NAME_None)
+	{
+		Reader.Serialize(Payload.GetData(), Payload.Num());
+	}
+
+	// Older files hold a single compressed buffer
+	else if (Header.Version < NeutronSaveVersionStreamed)
+	{
+		TArray<uint8> CompressedData;
+		CompressedData.SetNumUninitialized(FileReader->TotalSize() - FileReader->Tell());
+		FileReader->Serialize(CompressedData.GetData(), CompressedData.Num());
+
+		if (!UncompressSaveData(CodecName, Payload.GetData(), Payload.Num(), CompressedData.GetData(), CompressedData.Num()))
+		{
+			NERR("UNeutronSaveManager::ReadSaveFile : failed to uncompress with compressed size %d and uncompressed size %d",
+				CompressedData.Num(), Payload.Num());
+			return false;
+		}
+	}
+
+	// Current files are made of independently compressed blocks, streamed in small batches that are inflated in parallel
+	else
+	{
+		int64                     FooterSize = Header.Version >= NeutronSaveVersionChecksum ? sizeof(uint32) : 0;
+		int32                     BatchSize  = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1) * 2;
+		TArray<uint8>             CompressedData;
+		TArray<FNeutronSaveBlock> Blocks;
+		int64                     Offset = 0;
+
+		while (Offset < Payload.Num())
+		{
+			// Read the next batch of blocks, each preceded by its sizes
+			Blocks.Reset();
+			CompressedData.Reset();
+			while (Offset < Payload.Num() && Blocks.Num() < BatchSize)
+			{
+				int32 CompressedSize = 0;
+				int32 RawSize        = 0;
+				Reader << CompressedSize;
+				Reader << RawSize;
+
+				int64 AvailableSize = FileReader->TotalSize() - FooterSize - FileReader->Tell();
+				if (FileReader->IsError() || CompressedSize <= 0 || CompressedSize > AvailableSize || RawSize <= 0 ||
+					RawSize > Header.BlockSize || RawSize > Payload.Num() - Offset)
+				{
+					NERR("UNeutronSaveManager::ReadSaveFile : invalid block at offset %lld in '%s'", Offset, *Filename);
+					return false;
+				}
+
+				Blocks.Add(FNeutronSaveBlock{CompressedData.Num(), CompressedSize, Offset, RawSize});
+				CompressedData.AddUninitialized(CompressedSize);
+				Reader.Serialize(CompressedData.GetData() + Blocks.Last().CompressedOffset, CompressedSize);
+				Offset += RawSize;
+			}
+
+			// Inflate the batch straight into the payload, timing the whole parallel section as this load's inflate phase
+			NEUTRON_SAVE_SCOPE(Inflate);
+			FThreadSafeBool Failed = false;
+			ParallelFor(Blocks.Num(),
+				[&](int32 Index)
+				{
+					TRACE_CPUPROFILER_EVENT_SCOPE(NeutronSave_InflateBlock);
+
+					const FNeutronSaveBlock& Block = Blocks[Index];
+					if (!FCompression::UncompressMemory(CodecName, Payload.GetData() + Block.RawOffset, Block.RawSize,
+							CompressedData.GetData() + Block.CompressedOffset, Block.CompressedSize))
+					{
+						Failed = true;
+					}
+				});
+
+			if (Failed || FileReader->IsError())
+			{
+				NERR("UNeutronSaveManager::ReadSaveFile : failed to uncompress blocks in '%s'", *Filename);
+				return false;
+			}
+		}
+	}
+
+	// Verify the checksum of the data followed by the header
+	if (Header.Version >= NeutronSaveVersionChecksum)
+	{
+		TArray<uint8> HeaderData;
+		FMemoryWriter HeaderWriter(HeaderData);
+		HeaderWriter << Header;
+
+		uint32 ExpectedChecksum = FCrc::MemCrc32(HeaderData.GetData(), HeaderData.Num(), Reader.GetChecksum());
+		uint32 Checksum         = 0;
+		*FileReader << Checksum;
+
+		if (FileReader->IsError() || Checksum != ExpectedChecksum)
+		{
+			NERR("UNeutronSaveManager::ReadSaveFile : checksum mismatch in '%s'", *Filename);
+			return false;
+		}
+	}
+
+	return !FileReader->IsError();
+}
+
+bool UNeutronSaveManager::ReadSaveChecksum(const FString& Filename, uint32& Checksum)
+{
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!FileReader.IsValid() || FileReader->TotalSize() < static_cast<int64>(sizeof(uint32)))
+	{
+		return false;
+	}
+
+	FileReader->Seek(FileReader->TotalSize() - sizeof(uint32));
+	*FileReader << Checksum;
+
+	return !FileReader->IsError();
+}
+
+bool UNeutronSaveManager::WriteSaveTextFile(
+	const FString& Filename, const UScriptStruct* Struct, const void* SaveData, uint32 SchemaVersion)
+{
+	NEUTRON_SAVE_SCOPE(Serialize);
+
+	IFileHandle* Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename);
+	if (Handle == nullptr)
+	{
+		NERR("UNeutronSaveManager::WriteSaveTextFile : failed to open '%s'", *Filename);
+		return false;
+	}
+	FNeutronSaveFileWriter FileWriter(Handle);
+
+	// Stream the text through blocks written as-is
+	FNeutronCompressedWriter BlockWriter(FileWriter, NAME_None, NeutronSaveBlockSize);
+	auto                     JsonWriter = TJsonWriterFactory<UTF8CHAR, TCondensedJsonPrintPolicy<UTF8CHAR>>::Create(&BlockWriter);
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(NeutronJsonSchemaVersionField, static_cast<int64>(SchemaVersion));
+	JsonWriter->WriteValue(NeutronJsonStructField, Struct->GetPathName());
+	if (!WriteSaveJsonFields(Struct, SaveData, JsonWriter) || !BlockWriter.Finalize())
+	{
+		NERR("UNeutronSaveManager::WriteSaveTextFile : failed to serialize data");
+		return false;
+	}
+
+	// End with the checksum of all text before it
+	JsonWriter->WriteValue(NeutronJsonChecksumField, static_cast<int64>(FileWriter.GetChecksum()));
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+	if (!BlockWriter.Finalize())
+	{
+		return false;
+	}
+
+	NeutronSaveProfile.RawSize        = BlockWriter.GetUncompressedSize();
+	NeutronSaveProfile.CompressedSize = BlockWriter.GetUncompressedSize();
+
+	return FileWriter.Commit();
+}
+
+bool UNeutronSaveManager::ReadSaveTextFile(const FString& Filename, TArray<uint8>& Payload)
+{
+	NEUTRON_SAVE_SCOPE(Read);
+
+	if (!FFileHelper::LoadFileToArray(Payload, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	NeutronSaveProfile.RawSize        = Payload.Num();
+	NeutronSaveProfile.CompressedSize = Payload.Num();
+
+	// Verify the checksum field at the end of the text
+	const int32 MarkerLength = FCStringAnsi::Strlen(NeutronJsonChecksumMarker);
+	for (int32 Position = Payload.Num() - MarkerLength; Position >= FMath::Max(Payload.Num() - 64, 0); Position--)
+	{
+		if (FMemory::Memcmp(Payload.GetData() + Position, NeutronJsonChecksumMarker, MarkerLength) == 0)
+		{
+			int32   ValueOffset = Position + MarkerLength;
+			FString ChecksumText(Payload.Num() - ValueOffset, reinterpret_cast<const ANSICHAR*>(Payload.GetData() + ValueOffset));
+
+			if (static_cast<uint32>(FCString::Atoi64(*ChecksumText)) != FCrc::MemCrc32(Payload.GetData(), Position))
+			{
+				NERR("UNeutronSaveManager::ReadSaveTextFile : checksum mismatch in '%s'", *Filename);
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	// Saves starting with their schema version always end with a checksum, so a missing one means the end of the file was damaged
+	const FString      Prefix = FString::Printf(TEXT("{\"%s\":"), NeutronJsonSchemaVersionField);
+	const FTCHARToUTF8 PrefixConverter(*Prefix);
+	if (Payload.Num() >= PrefixConverter.Length() &&
+		FMemory::Memcmp(Payload.GetData(), PrefixConverter.Get(), PrefixConverter.Length()) == 0)
+	{
+		NERR("UNeutronSaveManager::ReadSaveTextFile : missing checksum in '%s'", *Filename);
+		return false;
+	}
+
+	// Older saves have no checksum and may not be UTF-8
+	FString SaveString;
+	FFileHelper::BufferToString(SaveString, Payload.GetData(), Payload.Num());
+	FTCHARToUTF8 Converter(*SaveString);
+	Payload = TArray<uint8>(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+
+	return true;
+}
+
+/*----------------------------------------------------
+    Incremental saves
+----------------------------------------------------*/
+
+bool UNeutronSaveManager::WriteSaveJournal(const FString SaveName, const UScriptStruct* Struct, const void* SaveData)
+{
+	NEUTRON_SAVE_SCOPE(Serialize);
+
+	FNeutronSaveJournalState* State = JournalStates.Find(SaveName);
+	if (State == nullptr || State->Format != SaveFormat)
+	{
+		return false;
+	}
+
+	TArray<TPair<FName, TArray<uint8>>> Sections;
+	if (!SerializeSaveSections(Struct, SaveData, SaveFormat, Sections))
+	{
+		return false;
+	}
+
+	// Find sections whose contents changed since they were last written, and build their journal records
+	TArray<uint8>       Records;
+	TMap<FName, uint64> ChangedSectionHashes;
+	FName               CodecName = GetCodecName(SaveCodec);
+	for (const TPair<FName, TArray<uint8>>& Section : Sections)
+	{
+		const TArray<uint8>& SectionData  = Section.Value;
+		uint64               Hash         = CityHash64(reinterpret_cast<const char*>(SectionData.GetData()), SectionData.Num());
+		const uint64*        PreviousHash = State->SectionHashes.Find(Section.Key);
+		if (PreviousHash == nullptr || *PreviousHash != Hash)
+		{
+			// Compress the section, or store it as-is
+			TArray<uint8> CompressedData;
+			uint8         Codec = static_cast<uint8>(ENeutronSaveCodec::None);
+			if (CodecName != NAME_None)
+			{
+				int32 CompressedSize = FCompression::CompressMemoryBound(CodecName, SectionData.Num());
+				CompressedData.SetNumUninitialized(CompressedSize);
+				if (CompressSaveData(CodecName, CompressedData.GetData(), CompressedSize, SectionData.GetData(), SectionData.Num()))
+				{
+					CompressedData.SetNum(CompressedSize);
+					Codec = static_cast<uint8>(SaveCodec);
+				}
+			}
+			if (Codec == static_cast<uint8>(ENeutronSaveCodec::None))
+			{
+				CompressedData = SectionData;
+			}
+
+			// Build the record
+			TArray<uint8>    Record;
+			FMemoryWriter    RecordWriter(Record);
+			const FProperty* Property    = Struct->FindPropertyByName(Section.Key);
+			FString          SectionName = Section.Key.ToString();
+			FString          SectionType = Property ? Property->GetCPPType() : FString();
+			int32            RawSize     = SectionData.Num();
+			RecordWriter << SectionName;
+			RecordWriter << SectionType;
+			RecordWriter << Codec;
+			RecordWriter << RawSize;
+			RecordWriter << CompressedData;
+
+			// Append it with its size and checksum
+			int32         RecordSize     = Record.Num();
+			uint32        RecordChecksum = FCrc::MemCrc32(Record.GetData(), Record.Num());
+			FMemoryWriter JournalWriter(Records, false, true);
+			JournalWriter << RecordSize;
+			JournalWriter.Serialize(Record.GetData(), Record.Num());
+			JournalWriter << RecordChecksum;
+
+			ChangedSectionHashes.Add(Section.Key, Hash);
+			NeutronSaveProfile.RawSize += SectionData.Num();
+		}
+	}
+
+	// Nothing to write
+	if (Records.Num() == 0)
+	{
+		NLOG("UNeutronSaveManager::WriteSaveJournal : no change in '%s'", *SaveName);
+		return true;
+	}
+
+	// Compact the journal into a new full save once it gets too large
+	if (State->JournalSize + Records.Num() > State->BaseSize * NeutronJournalCompactionRatio)
+	{
+		NLOG("UNeutronSaveManager::WriteSaveJournal : compacting '%s'", *SaveName);
+		return false;
+	}
+
+	// Start the journal with its header, tying it to the current full save
+	TArray<uint8> JournalData;
+	if (State->JournalSize == 0)
+	{
+		FMemoryWriter HeaderWriter(JournalData);
+		uint32        Magic         = NeutronJournalMagic;
+		uint32        Version       = NeutronJournalVersion;
+		uint8         Format        = static_cast<uint8>(State->Format);
+		uint32        SchemaVersion = GetSchemaVersion(Struct);
+		HeaderWriter << Magic;
+		HeaderWriter << Version;
+		HeaderWriter << Format;
+		HeaderWriter << State->BaseChecksum;
+		HeaderWriter << SchemaVersion;
+		WriteSaveVersions(HeaderWriter);
+	}
+	JournalData.Append(Records);
+
+	// Append to the journal and flush it to the storage device
+	NEUTRON_SAVE_SCOPE(Write);
+	FString                 JournalPath = GetSaveJournalPath(SaveName);
+	TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*JournalPath, true));
+	if (!Handle.IsValid() || !Handle->Write(JournalData.GetData(), JournalData.Num()) || !Handle->Flush(true))
+	{
+		NERR("UNeutronSaveManager::WriteSaveJournal : failed to write '%s'", *JournalPath);
+		return false;
+	}
+
+	NLOG("UNeutronSaveManager::WriteSaveJournal : wrote %d sections to '%s'", ChangedSectionHashes.Num(), *JournalPath);
+
+	State->JournalSize += JournalData.Num();
+	State->SectionHashes.Append(ChangedSectionHashes);
+	NeutronSaveProfile.CompressedSize = JournalData.Num();
+
+	return true;
+}
+
+void UNeutronSaveManager::ResetSaveJournal(
+	const FString SaveName, const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format)
+{
+	NEUTRON_SAVE_SCOPE(Serialize);
+
+	IFileManager::Get().Delete(*GetSaveJournalPath(SaveName), false, false, true);
+	JournalStates.Remove(SaveName);
+
+	if (IncrementalSaves)
+	{
+		FNeutronSaveJournalState State;
+		State.Format   = Format;
+		State.BaseSize = IFileManager::Get().FileSize(*GetSaveGamePath(SaveName, true));
+		if (!ReadSaveChecksum(GetSaveGamePath(SaveName, true), State.BaseChecksum))
+		{
+			return;
+		}
+
+		// Hash sections as they are on disk
+		TArray<TPair<FName, TArray<uint8>>> Sections;
+		if (!SerializeSaveSections(Struct, SaveData, Format, Sections))
+		{
+			return;
+		}
+		for (const TPair<FName, TArray<uint8>>& Section : Sections)
+		{
+			uint64 Hash = CityHash64(reinterpret_cast<const char*>(Section.Value.GetData()), Section.Value.Num());
+			State.SectionHashes.Add(Section.Key, Hash);
+		}
+
+		JournalStates.Add(SaveName, State);
+	}
+}
+
+bool UNeutronSaveManager::ReadSaveJournal(const FString SaveName, FNeutronSaveJournal& Journal) const
+{
+	TArray<uint8> JournalData;
+	uint32        BaseChecksum;
+	if (!FFileHelper::LoadFileToArray(JournalData, *GetSaveJournalPath(SaveName), FILEREAD_Silent) ||
+		!ReadSaveChecksum(GetSaveGamePath(SaveName, true), BaseChecksum))
+	{
+		return false;
+	}
+
+	// Check that the journal was written on top of this save
+	FMemoryReader JournalReader(JournalData);
+	uint32        Magic       = 0;
+	uint8         Format      = 0;
+	uint32        JournalBase = 0;
+	JournalReader << Magic;
+	JournalReader << Journal.Version;
+	JournalReader << Format;
+	JournalReader << JournalBase;
+	if (JournalReader.IsError() || Magic != NeutronJournalMagic || Journal.Version > NeutronJournalVersion || JournalBase != BaseChecksum)
+	{
+		NLOG("UNeutronSaveManager::ReadSaveJournal : ignoring stale journal for '%s'", *SaveName);
+		return false;
+	}
+	if (Journal.Version >= NeutronJournalVersionSchema)
+	{
+		JournalReader << Journal.SchemaVersion;
+	}
+	Journal.Format = static_cast<ENeutronSaveFormat>(Format);
+
+	// Keep the engine versions that binary sections were written with
+	int64 VersionStart = JournalReader.Tell();
+	ReadSaveVersions(JournalReader);
+	Journal.VersionData = TArray<uint8>(JournalData.GetData() + VersionStart, static_cast<int32>(JournalReader.Tell() - VersionStart));
+
+	// Read records in order, stopping at the first incomplete one
+	while (!JournalReader.AtEnd())
+	{
+		int32 RecordSize = 0;
+		JournalReader << RecordSize;
+		if (JournalReader.IsError() || RecordSize <= 0 ||
+			RecordSize > JournalReader.TotalSize() - JournalReader.Tell() - static_cast<int64>(sizeof(uint32)))
+		{
+			break;
+		}
+
+		const uint8* RecordData = JournalData.GetData() + JournalReader.Tell();
+		uint32       RecordChecksum;
+		JournalReader.Seek(JournalReader.Tell() + RecordSize);
+		JournalReader << RecordChecksum;
+		if (RecordChecksum != FCrc::MemCrc32(RecordData, RecordSize))
+		{
+			NERR("UNeutronSaveManager::ReadSaveJournal : damaged record in journal for '%s'", *SaveName);
+			break;
+		}
+
+		// Read the record
+		FMemoryReaderView          RecordReader(TArrayView<const uint8>(RecordData, RecordSize));
+		FNeutronSaveJournalSection Section;
+		uint8                      Codec;
+		int32                      RawSize;
+		TArray<uint8>              CompressedData;
+		RecordReader << Section.Name;
+		RecordReader << Section.Type;
+		RecordReader << Codec;
+		RecordReader << RawSize;
+		RecordReader << CompressedData;
+		if (RecordReader.IsError() || RawSize < 0)
+		{
+			NERR("UNeutronSaveManager::ReadSaveJournal : failed to read section '%s'", *Section.Name);
+			continue;
+		}
+
+		// Decompress
+		FName CodecName = GetCodecName(static_cast<ENeutronSaveCodec>(Codec));
+		if (CodecName == NAME_None)
+		{
+			Section.Data = MoveTemp(CompressedData);
+		}
+		else
+		{
+			Section.Data.SetNumUninitialized(RawSize);
+			if (!UncompressSaveData(CodecName, Section.Data.GetData(), RawSize, CompressedData.GetData(), CompressedData.Num()))
+			{
+				NERR("UNeutronSaveManager::ReadSaveJournal : failed to uncompress section '%s'", *Section.Name);
+				continue;
+			}
+		}
+
+		Journal.Sections.Add(MoveTemp(Section));
+	}
+
+	NLOG("UNeutronSaveManager::ReadSaveJournal : read %d sections for '%s'", Journal.Sections.Num(), *SaveName);
+
+	return true;
+}
+
+bool UNeutronSaveManager::FoldSaveJournal(
+	const FNeutronSaveJournal& Journal, const TSharedPtr<FJsonObject>& JsonData, TArray<uint8>& Payload)
+{
+	NEUTRON_SAVE_SCOPE(Parse);
+
+	// JSON sections are objects with their property as their only field, replacing the field of the tree
+	if (JsonData.IsValid())
+	{
+		for (const FNeutronSaveJournalSection& Section : Journal.Sections)
+		{
+			FUTF8ToTCHAR            Converter(reinterpret_cast<const ANSICHAR*>(Section.Data.GetData()), Section.Data.Num());
+			TSharedPtr<FJsonObject> SectionData;
+			if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(FString(Converter.Length(), Converter.Get())), SectionData) ||
+				!SectionData.IsValid())
+			{
+				NERR("UNeutronSaveManager::FoldSaveJournal : failed to parse section '%s'", *Section.Name);
+				return false;
+			}
+
+			for (const auto& Field : SectionData->Values)
+			{
+				JsonData->SetField(Field.Key, Field.Value);
+			}
+		}
+	}
+
+	// Binary sections are the tagged values of their property, replacing those of the payload or added before its terminator
+	else
+	{
+		TArray<FNeutronSaveTaggedRange> Ranges;
+		int64                           TagsStart;
+		int64                           TagsEnd;
+		if (!ReadSaveTaggedRanges(Payload, Ranges, TagsStart, TagsEnd))
+		{
+			NERR("UNeutronSaveManager::FoldSaveJournal : failed to read the tags of the save");
+			return false;
+		}
+
+		TMap<FName, const TArray<uint8>*> SectionsByName;
+		for (const FNeutronSaveJournalSection& Section : Journal.Sections)
+		{
+			SectionsByName.Add(FName(*Section.Name), &Section.Data);
+		}
+
+		TArray<uint8> FoldedPayload;
+		FoldedPayload.Reserve(Payload.Num());
+		FoldedPayload.Append(Payload.GetData(), static_cast<int32>(TagsStart));
+		for (const FNeutronSaveTaggedRange& Range : Ranges)
+		{
+			const TArray<uint8>* SectionData = nullptr;
+			if (SectionsByName.RemoveAndCopyValue(Range.Name, SectionData))
+			{
+				FoldedPayload.Append(*SectionData);
+			}
+			else
+			{
+				FoldedPayload.Append(Payload.GetData() + Range.Start, static_cast<int32>(Range.End - Range.Start));
+			}
+		}
+		for (const TPair<FName, const TArray<uint8>*>& Section : SectionsByName)
+		{
+			FoldedPayload.Append(*Section.Value);
+		}
+		FoldedPayload.Append(Payload.GetData() + TagsEnd, static_cast<int32>(Payload.Num() - TagsEnd));
+
+		Payload = MoveTemp(FoldedPayload);
+	}
+
+	return true;
+}
+
+bool UNeutronSaveManager::SerializeSaveSections(
+	const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, TArray<TPair<FName, TArray<uint8>>>& Sections)
+{
+	// Write JSON sections as UTF-8 objects with the property as their only field
+	if (Format == ENeutronSaveFormat::Json)
+	{
+		for (TFieldIterator<FProperty> PropIt(Struct); PropIt; ++PropIt)
+		{
+			FProperty*              Property = *PropIt;
+			TSharedRef<FJsonObject> JsonData = MakeShared<FJsonObject>();
+			if (Property->ArrayDim == 1)
+			{
+				JsonData->SetField(Property->GetName(),
+					FJsonObjectConverter::UPropertyToJsonValue(Property, Property->ContainerPtrToValuePtr<void>(SaveData)));
+			}
+			else
+			{
+				TArray<TSharedPtr<FJsonValue>> Values;
+				for (int32 Index = 0; Index < Property->ArrayDim; Index++)
+				{
+					Values.Add(
+						FJsonObjectConverter::UPropertyToJsonValue(Property, Property->ContainerPtrToValuePtr<void>(SaveData, Index)));
+				}
+				JsonData->SetArrayField(Property->GetName(), Values);
+			}
+
+			TArray<uint8>& SectionData = Sections.Emplace_GetRef(Property->GetFName(), TArray<uint8>()).Value;
+			FMemoryWriter  SectionWriter(SectionData);
+			auto           JsonWriter = TJsonWriterFactory<UTF8CHAR, TCondensedJsonPrintPolicy<UTF8CHAR>>::Create(&SectionWriter);
+			if (!FJsonSerializer::Serialize(JsonData, JsonWriter))
+			{
+				return false;
+			}
+
+			JsonWriter->Close();
+		}
+	}
+
+	// Write binary sections as the tagged values of each property in a full save
+	else
+	{
+		TArray<uint8>                   Data;
+		FMemoryWriter                   Writer(Data, true);
+		TArray<FNeutronSaveTaggedRange> Ranges;
+		int64                           TagsStart;
+		int64                           TagsEnd;
+		if (!SerializeSaveData(Struct, SaveData, Format, Writer) || !ReadSaveTaggedRanges(Data, Ranges, TagsStart, TagsEnd))
+		{
+			return false;
+		}
+
+		for (const FNeutronSaveTaggedRange& Range : Ranges)
+		{
+			Sections.Emplace(Range.Name, TArray<uint8>(Data.GetData() + Range.Start, static_cast<int32>(Range.End - Range.Start)));
+		}
+	}
+
+	return true;
+}
+
+bool UNeutronSaveManager::DeserializeSaveSection(const FProperty* Property, void* SaveData, FArchive& Archive)
+{
+	NEUTRON_SAVE_SCOPE(Parse);
+
+	FObjectAndNameAsStringProxyArchive ProxyArchive(Archive, true);
+	for (int32 Index = 0; Index < Property->ArrayDim; Index++)
+	{
+		FStructuredArchiveFromArchive StructuredArchive(ProxyArchive);
+		const_cast<FProperty*>(Property)->SerializeItem(
+			StructuredArchive.GetSlot(), Property->ContainerPtrToValuePtr<void>(SaveData, Index), nullptr);
+	}
+
+	return !Archive.IsError();
+}
+
+/*----------------------------------------------------
+    Migrations
+----------------------------------------------------*/
+
+void UNeutronSaveManager::RegisterSaveMigration(const UScriptStruct* Struct, uint32 FromVersion, FNeutronSaveMigration Migration)
+{
+	NCHECK(Struct);
+	NCHECK(Migration.Json || Migration.Binary);
+
+	TArray<FNeutronSaveMigration>& Migrations = SaveMigrations.FindOrAdd(Struct);
+	if (Migrations.Num() <= static_cast<int32>(FromVersion))
+	{
+		Migrations.SetNum(FromVersion + 1);
+	}
+	Migrations[FromVersion] = Migration;
+}
+
+uint32 UNeutronSaveManager::GetSchemaVersion(const UScriptStruct* Struct) const
+{
+	const TArray<FNeutronSaveMigration>* Migrations = SaveMigrations.Find(Struct);
+
+	return Migrations ? Migrations->Num() : 0;
+}
+
+int32 UNeutronSaveManager::UpgradeAllSaves(const UScriptStruct* Struct)
+{
+	NCHECK(Struct);
+
+	// Find outdated saves of this structure from the index, other save types sharing the directory being left alone
+	uint32          CurrentVersion = GetSchemaVersion(Struct);
+	FString         StructPath     = Struct->GetPathName();
+	TArray<FString> SaveNames;
+	for (const FNeutronSaveSlotInfo& Info : EnumerateSaves())
+	{
+		if (Info.StructPath != StructPath)
+		{
+			NLOG("UNeutronSaveManager::UpgradeAllSaves : skipping '%s' holding '%s'", *Info.SlotName, *Info.StructPath);
+		}
+		else if (static_cast<uint32>(Info.SchemaVersion) < CurrentVersion)
+		{
+			SaveNames.Add(Info.SlotName);
+		}
+	}
+
+	NLOG("UNeutronSaveManager::UpgradeAllSaves : upgrading %d saves to schema version %d", SaveNames.Num(), CurrentVersion);
+
+	// Read, migrate and deserialize saves in parallel, writing them back one at a time under the save lock, as they were stored
+	FThreadSafeCounter UpgradedCount;
+	ParallelFor(SaveNames.Num(),
+		[&](int32 Index)
+		{
+			const FString&     SaveName = SaveNames[Index];
+			ENeutronSaveFormat Format   = SaveFormat;
+			ENeutronSaveCodec  Codec    = SaveCodec;
+
+			void* SaveData = FMemory::Malloc(Struct->GetStructureSize(), Struct->GetMinAlignment());
+			Struct->InitializeStruct(SaveData);
+
+			if (LoadGameInternal(SaveName, Struct, SaveData, &Format, &Codec) && SaveGame(SaveName, Struct, SaveData, Format, Codec))
+			{
+				UpgradedCount.Increment();
+			}
+			else
+			{
+				NERR("UNeutronSaveManager::UpgradeAllSaves : failed to upgrade '%s'", *SaveName);
+			}
+
+			Struct->DestroyStruct(SaveData);
+			FMemory::Free(SaveData);
+		});
+
+	return UpgradedCount.GetValue();
+}
+
+/** Upgrade all saves of a structure to its current schema version */
+static FAutoConsoleCommand NeutronUpgradeAllSavesCommand(TEXT("Neutron.UpgradeAllSaves"),
+	TEXT("Upgrade all saves to the current schema version - takes the name of the save data structure"),
+	FConsoleCommandWithArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args)
+		{
+			UScriptStruct* Struct = nullptr;
+			if (Args.Num() == 1)
+			{
+				Struct = FindFirstObject<UScriptStruct>(*Args[0], EFindFirstObjectOptions::NativeFirst);
+			}
+
+			if (Struct == nullptr || UNeutronSaveManager::Get() == nullptr)
+			{
+				NERR("Neutron.UpgradeAllSaves : expected the name of a save data structure");
+				return;
+			}
+
+			int32 UpgradedCount = UNeutronSaveManager::Get()->UpgradeAllSaves(Struct);
+			NLOG("Neutron.UpgradeAllSaves : upgraded %d saves", UpgradedCount);
+		}));
+
+/*----------------------------------------------------
+    Save index
+----------------------------------------------------*/
+
+/** Check whether a file found in the save directory starts like a save, and get its schema version and structure */
+static bool ReadSaveFileStart(const FString& Path, bool Compressed, int32& SchemaVersion, FString& StructPath)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path, FILEREAD_Silent));
+	if (!Reader.IsValid())
+	{
+		return false;
+	}
+
+	uint8 Start[512];
+	int32 StartSize = static_cast<int32>(FMath::Min(Reader->TotalSize(), static_cast<int64>(sizeof(Start))));
+	Reader->Serialize(Start, StartSize);
+	if (Reader->IsError())
+	{
+		return false;
+	}
+
+	SchemaVersion = 0;
+	StructPath.Reset();
+
+	// Compressed saves have a header, or start with a big-endian size followed by a zlib stream for legacy saves
+	if (Compressed)
+	{
+		FNeutronSaveHeader Header;
+		FMemoryReader      HeaderReader(TArrayView<const uint8>(Start, StartSize));
+		HeaderReader << Header;
+		if (!HeaderReader.IsError() && Header.Magic == NeutronSaveMagic)
+		{
+			SchemaVersion = Header.SchemaVersion;
+			StructPath    = Header.StructPath;
+			return true;
+		}
+
+		return StartSize > 4 && Start[4] == 0x78;
+	}
+
+	// Plain saves are condensed JSON objects, in UTF-16 for some legacy saves
+	if (StartSize >= 2 && Start[0] == 0xFF && Start[1] == 0xFE)
+	{
+		return StartSize >= 6 && Start[2] == '{' && Start[4] == '"';
+	}
+	else if (StartSize < 2 || Start[0] != '{' || Start[1] != '"')
+	{
+		return false;
+	}
+
+	// Current plain saves start with their schema version, followed by their structure
+	FString StartText(StartSize, reinterpret_cast<const ANSICHAR*>(Start));
+	FString Prefix = FString::Printf(TEXT("{\"%s\":"), NeutronJsonSchemaVersionField);
+	if (StartText.StartsWith(Prefix))
+	{
+		SchemaVersion = FMath::Max(FCString::Atoi(*StartText + Prefix.Len()), 0);
+
+		FString StructPrefix = FString::Printf(TEXT(",\"%s\":\""), NeutronJsonStructField);
+		int32   StructStart  = StartText.Find(StructPrefix, ESearchCase::CaseSensitive);
+		if (StructStart != INDEX_NONE)
+		{
+			FString StructText = StartText.Mid(StructStart + StructPrefix.Len());
+			int32   StructEnd  = INDEX_NONE;
+			if (StructText.FindChar(TEXT('"'), StructEnd))
+			{
+				StructPath = StructText.Left(StructEnd);
+			}
+		}
+	}
+
+	return true;
+}
+
+void UNeutronSaveManager::LoadSaveIndex()
+{
+	if (SaveIndexLoaded)
+	{
+		return;
+	}
+	SaveIndexLoaded = true;
+
+	// Read the index
+	TArray<uint8> IndexData;
+	if (FFileHelper::LoadFileToArray(IndexData, *GetSaveIndexPath(), FILEREAD_Silent))
+	{
+		FMemoryReader Reader(IndexData);
+		uint32        Magic    = 0;
+		uint32        Version  = 0;
+		uint32        Checksum = 0;
+
+		Reader << Magic;
+		Reader << Version;
+		Reader << Checksum;
+
+		// Only read entries with a valid checksum
+		int64 EntriesOffset = Reader.Tell();
+		if (!Reader.IsError() && Magic == NeutronSaveIndexMagic && Version == NeutronSaveIndexVersion &&
+			Checksum == FCrc::MemCrc32(IndexData.GetData() + EntriesOffset, IndexData.Num() - EntriesOffset))
+		{
+			Reader << SaveIndex;
+			if (!Reader.IsError())
+			{
+				NLOG("UNeutronSaveManager::LoadSaveIndex : %d saves", SaveIndex.Num());
+				return;
+			}
+		}
+
+		NERR("UNeutronSaveManager::LoadSaveIndex : invalid index, rebuilding it");
+		SaveIndex.Empty();
+	}
+
+	// Rebuild the index from the save files, reading only their start
+	IFileManager&   FileManager = IFileManager::Get();
+	TArray<FString> Filenames;
+	FileManager.FindFiles(Filenames, *(FPaths::ProjectSavedDir() / TEXT("*.sav")), true, false);
+	FileManager.FindFiles(Filenames, *(FPaths::ProjectSavedDir() / TEXT("*.json")), true, false);
+
+	for (const FString& Filename : Filenames)
+	{
+		FString              Path       = FPaths::ProjectSavedDir() / Filename;
+		bool                 Compressed = FPaths::GetExtension(Filename) == TEXT("sav");
+		FNeutronSaveSlotInfo Info;
+
+		// Skip other files sharing the save extensions
+		if (!ReadSaveFileStart(Path, Compressed, Info.SchemaVersion, Info.StructPath))
+		{
+			NLOG("UNeutronSaveManager::LoadSaveIndex : skipping '%s'", *Filename);
+			continue;
+		}
+
+		Info.SlotName  = FPaths::GetBaseFilename(Filename);
+		Info.Timestamp = FileManager.GetTimeStamp(*Path);
+		Info.Size      = FileManager.FileSize(*Path);
+
+		if (Compressed)
+		{
+			int64 JournalSize = FileManager.FileSize(*GetSaveJournalPath(Info.SlotName));
+			if (JournalSize > 0)
+			{
+				Info.Size += JournalSize;
+			}
+		}
+
+		SaveIndex.Add(Info.SlotName, Info);
+	}
+
+	NLOG("UNeutronSaveManager::LoadSaveIndex : rebuilt index with %d saves", SaveIndex.Num());
+
+	WriteSaveIndex();
+}
+
+void UNeutronSaveManager::WriteSaveIndex()
+{
+	TArray<uint8> EntriesData;
+	FMemoryWriter EntriesWriter(EntriesData);
+	EntriesWriter << SaveIndex;
+
+	TArray<uint8> IndexData;
+	FMemoryWriter Writer(IndexData);
+	uint32        Magic    = NeutronSaveIndexMagic;
+	uint32        Version  = NeutronSaveIndexVersion;
+	uint32        Checksum = FCrc::MemCrc32(EntriesData.GetData(), EntriesData.Num());
+
+	Writer << Magic;
+	Writer << Version;
+	Writer << Checksum;
+	Writer.Serialize(EntriesData.GetData(), EntriesData.Num());
+
+	// Replace the index atomically so that it is never left partially written
+	if (!FFileHelper::SaveArrayToFile(IndexData, *GetSaveIndexPath(true)) ||
+		!IFileManager::Get().Move(*GetSaveIndexPath(), *GetSaveIndexPath(true), true, true, false, true))
+	{
+		NERR("UNeutronSaveManager::WriteSaveIndex : failed to write the index");
+	}
+}
+
+void UNeutronSaveManager::UpdateSaveIndex(const FString SaveName, bool Compressed, const UScriptStruct* Struct, uint32 SchemaVersion)
+{
+	NEUTRON_SAVE_SCOPE(Write);
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	SaveIndexLock.Lock();
+	LoadSaveIndex();
+
+	FNeutronSaveSlotInfo& Info = SaveIndex.FindOrAdd(SaveName);
+	Info.SlotName              = SaveName;
+	Info.Timestamp             = FDateTime::UtcNow();
+	Info.Size                  = FileManager.FileSize(*GetSaveGamePath(SaveName, Compressed));
+	Info.SchemaVersion         = SchemaVersion;
+	Info.StructPath            = Struct->GetPathName();
+
+	if (Compressed)
+	{
+		int64 JournalSize = FileManager.FileSize(*GetSaveJournalPath(SaveName));
+		if (JournalSize > 0)
+		{
+			Info.Size += JournalSize;
+		}
+	}
+
+	// Apply the game summary set for this save
+	FNeutronSaveSlotInfo PendingSummary;
+	if (PendingSaveSummaries.RemoveAndCopyValue(SaveName, PendingSummary))
+	{
+		Info.Summary   = MoveTemp(PendingSummary.Summary);
+		Info.Thumbnail = MoveTemp(PendingSummary.Thumbnail);
+	}
+
+	WriteSaveIndex();
+
+	SaveIndexLock.Unlock();
+}
+
+/*----------------------------------------------------
+    Benchmarks
+----------------------------------------------------*/
+
+#if !UE_BUILD_SHIPPING
+
+// Parameters of the save automation tests
+static TAutoConsoleVariable<int32> CVarNeutronSaveTestSize(TEXT("Neutron.SaveTestSize"), 4096,
+	TEXT("Approximate serialized size in kilobytes of the random save data used by the save automation tests"));
+
+static TAutoConsoleVariable<int32> CVarNeutronSaveTestDepth(TEXT("Neutron.SaveTestDepth"), 3,
+	TEXT("Nesting depth of the random save data used by the save automation tests"));
+
+static TAutoConsoleVariable<int32> CVarNeutronSaveTestIterations(TEXT("Neutron.SaveTestIterations"), 5,
+	TEXT("Number of timed saves and loads per format in the save round trip test"));
+
+static TAutoConsoleVariable<int32> CVarNeutronSaveTestFuzzIterations(TEXT("Neutron.SaveTestFuzzIterations"), 250,
+	TEXT("Number of damaged copies loaded per format in the save fuzzing test"));
+
+static TAutoConsoleVariable<int32> CVarNeutronSaveTestSeed(TEXT("Neutron.SaveTestSeed"), 0,
+	TEXT("Random seed of the save automation tests, zero picking a new one for each run"));
+
+/** Build a random synthetic save entry with children down to a depth, using up its approximate size from the remaining size */
+static void BuildBenchmarkSaveEntry(FNeutronSaveBenchmarkEntry& Entry, FRandomStream& Random, int32 Depth, int64& RemainingSize)
+{
+	Entry.Identifier = FGuid(Random.GetUnsignedInt(), Random.GetUnsignedInt(), Random.GetUnsignedInt(), Random.GetUnsignedInt());
+	Entry.Count      = Random.RandRange(0, 1000000);
+	Entry.Value      = Random.GetFraction();
+
+	// Names of random length, with some characters outside of ASCII
+	for (int32 Index = Random.RandRange(1, 32); Index > 0; Index--)
+	{
+		Entry.Name.AppendChar(Random.RandRange(0, 15) == 0 ? TCHAR(0xE0 + Random.RandRange(0, 15)) : TCHAR('a' + Random.RandRange(0, 25)));
+	}
+
+	for (int32 Index = Random.RandRange(0, 32); Index > 0; Index--)
+	{
+		Entry.History.Add(Random.RandRange(0, 1000));
+	}
+
+	RemainingSize -= NeutronSaveBenchmarkEntrySize;
+
+	for (int32 Index = Depth > 1 ? Random.RandRange(0, 4) : 0; Index > 0 && RemainingSize > 0; Index--)
+	{
+		BuildBenchmarkSaveEntry(Entry.Children.AddDefaulted_GetRef(), Random, Depth - 1, RemainingSize);
+	}
+}
+
+/** Build random synthetic save data of roughly the requested serialized size, nested down to a depth */
+static void BuildBenchmarkSaveData(FNeutronSaveBenchmarkData& SaveData, int64 Size, int32 Depth, int32 Seed)
+{
+	FRandomStream Random(Seed);
+	int64         RemainingSize = FMath::Max(Size, static_cast<int64>(1));
+
+	SaveData.Entries.Reset();
+	while (RemainingSize > 0)
+	{
+		BuildBenchmarkSaveEntry(SaveData.Entries.AddDefaulted_GetRef(), Random, Depth, RemainingSize);
+	}
+}
+
+/** Get a percentile of sorted samples */
+static double GetSamplePercentile(const TArray<double>& SortedSamples, double Percentile)
+{
+	int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedSamples.Num()) - 1, 0, SortedSamples.Num() - 1);
+	return SortedSamples[Index];
+}
+
+/** Get the physical memory used by the process in megabytes */
+static double GetUsedMemoryMegabytes()
+{
+	return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+}
+
+bool UNeutronSaveManager::BenchmarkSaves(int64 Size, int32 Depth, int32 Iterations, int32 Seed)
+{
+	const FString        SaveName = TEXT("NeutronSaveBenchmark");
+	const UScriptStruct* Struct   = FNeutronSaveBenchmarkData::StaticStruct();
+
+	double                    StartMemory = GetUsedMemoryMegabytes();
+	FNeutronSaveBenchmarkData SaveData;
+	BuildBenchmarkSaveData(SaveData, Size, Depth, Seed);
+
+	// Only measure full saves
+	ENeutronSaveFormat PreviousFormat           = SaveFormat;
+	bool               PreviousIncrementalSaves = IncrementalSaves;
+	IncrementalSaves                            = false;
+
+	bool Result = true;
+	for (ENeutronSaveFormat Format : {ENeutronSaveFormat::Json, ENeutronSaveFormat::Binary})
+	{
+		for (bool Compress : {false, true})
+		{
+			SaveFormat = Format;
+
+			TArray<double> SaveTimes;
+			TArray<double> LoadTimes;
+			int64          RawSize    = 0;
+			int64          FileSize   = 0;
+			double         PeakMemory = GetUsedMemoryMegabytes();
+			bool           Success    = true;
+			for (int32 Iteration = 0; Iteration < Iterations && Success; Iteration++)
+			{
+				// Save
+				double StartTime = FPlatformTime::Seconds();
+				bool   Saved     = SaveGame(SaveName, Struct, &SaveData, Compress);
+				SaveTimes.Add(FPlatformTime::Seconds() - StartTime);
+				RawSize    = NeutronSaveProfile.RawSize;
+				FileSize   = NeutronSaveProfile.CompressedSize;
+				PeakMemory = FMath::Max(PeakMemory, GetUsedMemoryMegabytes());
+
+				// Load and check the round trip, sampling memory while the loaded data is still alive
+				FNeutronSaveBenchmarkData LoadedData;
+				StartTime   = FPlatformTime::Seconds();
+				bool Loaded = Saved && LoadGameInternal(SaveName, Struct, &LoadedData);
+				LoadTimes.Add(FPlatformTime::Seconds() - StartTime);
+				PeakMemory = FMath::Max(PeakMemory, GetUsedMemoryMegabytes());
+
+				Success = Loaded && Struct->CompareScriptStruct(&SaveData, &LoadedData, PPF_None);
+			}
+
+			DeleteGame(SaveName);
+
+			if (!Success)
+			{
+				NERR("UNeutronSaveManager::BenchmarkSaves : round trip failed with format %d, compressed %d, seed %d",
+					static_cast<int32>(Format), Compress, Seed);
+				Result = false;
+				continue;
+			}
+
+			// Report throughput at the median, latency percentiles, and memory use over what was used before building the data
+			SaveTimes.Sort();
+			LoadTimes.Sort();
+			double Megabytes = RawSize / (1024.0 * 1024.0);
+			NLOG("UNeutronSaveManager::BenchmarkSaves : format %d, compressed %d, %lld bytes to %lld, save %.1f MB/s (p50 %.2fms, "
+				 "p90 %.2fms, p99 %.2fms), load %.1f MB/s (p50 %.2fms, p90 %.2fms, p99 %.2fms), peak memory +%.1f MB",
+				static_cast<int32>(Format), Compress, RawSize, FileSize, Megabytes / GetSamplePercentile(SaveTimes, 0.5),
+				GetSamplePercentile(SaveTimes, 0.5) * 1000.0, GetSamplePercentile(SaveTimes, 0.9) * 1000.0,
+				GetSamplePercentile(SaveTimes, 0.99) * 1000.0, Megabytes / GetSamplePercentile(LoadTimes, 0.5),
+				GetSamplePercentile(LoadTimes, 0.5) * 1000.0, GetSamplePercentile(LoadTimes, 0.9) * 1000.0,
+				GetSamplePercentile(LoadTimes, 0.99) * 1000.0, PeakMemory - StartMemory);
+		}
+	}
+
+	SaveFormat       = PreviousFormat;
+	IncrementalSaves = PreviousIncrementalSaves;
+
+	NLOG("UNeutronSaveManager::BenchmarkSaves : process peak memory %.1f MB",
+		FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0));
+
+	return Result;
+}
+
+bool UNeutronSaveManager::FuzzSaves(int64 Size, int32 Depth, int32 Iterations, int32 Seed)
+{
+	const FString        SaveName = TEXT("NeutronSaveFuzz");
+	const UScriptStruct* Struct   = FNeutronSaveBenchmarkData::StaticStruct();
+
+	double                    StartMemory = GetUsedMemoryMegabytes();
+	double                    PeakMemory  = StartMemory;
+	FNeutronSaveBenchmarkData SaveData;
+	BuildBenchmarkSaveData(SaveData, Size, Depth, Seed);
+
+	// Only keep the save file itself, so that loading has nothing to fall back to once it is damaged
+	ENeutronSaveFormat PreviousFormat           = SaveFormat;
+	bool               PreviousIncrementalSaves = IncrementalSaves;
+	int32              PreviousBackupCount      = BackupCount;
+	IncrementalSaves                            = false;
+	DeleteGame(SaveName);
+	BackupCount = 0;
+
+	FRandomStream Random(Seed);
+	int32         RejectedCount = 0;
+	int32         IntactCount   = 0;
+	int32         FailureCount  = 0;
+	for (ENeutronSaveFormat Format : {ENeutronSaveFormat::Json, ENeutronSaveFormat::Binary})
+	{
+		for (bool Compress : {false, true})
+		{
+			SaveFormat = Format;
+
+			FString       Filename = GetSaveGamePath(SaveName, Format != ENeutronSaveFormat::Json || Compress);
+			TArray<uint8> OriginalData;
+			if (!SaveGame(SaveName, Struct, &SaveData, Compress) || !FFileHelper::LoadFileToArray(OriginalData, *Filename))
+			{
+				NERR("UNeutronSaveManager::FuzzSaves : failed to save with format %d, compressed %d", static_cast<int32>(Format), Compress);
+				FailureCount++;
+				continue;
+			}
+
+			for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				// Truncate the file, or flip bits in it with half of them in the header
+				TArray<uint8> DamagedData = OriginalData;
+				if (Random.RandRange(0, 1) == 0)
+				{
+					DamagedData.SetNum(Random.RandRange(0, DamagedData.Num() - 1));
+				}
+				else
+				{
+					for (int32 FlipIndex = Random.RandRange(1, 8); FlipIndex > 0; FlipIndex--)
+					{
+						int32 Limit  = Random.RandRange(0, 1) == 0 ? FMath::Min(DamagedData.Num(), 64) : DamagedData.Num();
+						int32 Offset = Random.RandRange(0, Limit - 1);
+						DamagedData[Offset] ^= 1 << Random.RandRange(0, 7);
+					}
+				}
+				FFileHelper::SaveArrayToFile(DamagedData, *Filename);
+
+				// Loading has to either fail cleanly or get the original data back
+				FNeutronSaveBenchmarkData LoadedData;
+				bool                      Loaded = LoadGameInternal(SaveName, Struct, &LoadedData);
+				PeakMemory                       = FMath::Max(PeakMemory, GetUsedMemoryMegabytes());
+				if (!Loaded)
+				{
+					RejectedCount++;
+				}
+				else if (Struct->CompareScriptStruct(&SaveData, &LoadedData, PPF_None))
+				{
+					IntactCount++;
+				}
+				else
+				{
+					NERR("UNeutronSaveManager::FuzzSaves : damaged save loaded with different data, format %d, compressed %d, "
+						 "iteration %d, seed %d",
+						static_cast<int32>(Format), Compress, Iteration, Seed);
+					FailureCount++;
+				}
+			}
+
+			DeleteGame(SaveName);
+		}
+	}
+
+	SaveFormat       = PreviousFormat;
+	IncrementalSaves = PreviousIncrementalSaves;
+	BackupCount      = PreviousBackupCount;
+
+	NLOG("UNeutronSaveManager::FuzzSaves : %d damaged saves rejected, %d loaded intact, %d failures, peak memory +%.1f MB, process peak "
+		 "memory %.1f MB",
+		RejectedCount, IntactCount, FailureCount, PeakMemory - StartMemory,
+		FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0));
+
+	return FailureCount == 0;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Get the random seed for a save automation test run */
+static int32 GetSaveTestSeed()
+{
+	int32 Seed = CVarNeutronSaveTestSeed.GetValueOnAnyThread();
+	return Seed != 0 ? Seed : static_cast<int32>(FPlatformTime::Cycles());
+}
+
+/** Round trip random data through every save format, timing it */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNeutronSaveRoundTripTest, "Neutron.Save.RoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNeutronSaveRoundTripTest::RunTest(const FString& Parameters)
+{
+	TStrongObjectPtr<UNeutronSaveManager> SaveManager(NewObject<UNeutronSaveManager>());
+	int32                                 Seed = GetSaveTestSeed();
+
+	AddInfo(FString::Printf(TEXT("Seed %d"), Seed));
+	int64 Size       = static_cast<int64>(CVarNeutronSaveTestSize.GetValueOnAnyThread()) * 1024;
+	int32 Depth      = FMath::Max(CVarNeutronSaveTestDepth.GetValueOnAnyThread(), 1);
+	int32 Iterations = FMath::Max(CVarNeutronSaveTestIterations.GetValueOnAnyThread(), 1);
+	TestTrue(TEXT("Saves load back identical in every format"), SaveManager->BenchmarkSaves(Size, Depth, Iterations, Seed));
+
+	return true;
+}
+
+/** Load damaged copies of random saves in every format */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNeutronSaveFuzzTest, "Neutron.Save.Fuzz",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNeutronSaveFuzzTest::RunTest(const FString& Parameters)
+{
+	TStrongObjectPtr<UNeutronSaveManager> SaveManager(NewObject<UNeutronSaveManager>());
+	int32                                 Seed = GetSaveTestSeed();
+
+	// Damaged saves are expected to be reported while they are rejected
+	AddExpectedError(TEXT("UNeutronSaveManager::"), EAutomationExpectedErrorFlags::Contains, 0);
+
+	AddInfo(FString::Printf(TEXT("Seed %d"), Seed));
+	int64 Size       = static_cast<int64>(CVarNeutronSaveTestSize.GetValueOnAnyThread()) * 1024;
+	int32 Depth      = FMath::Max(CVarNeutronSaveTestDepth.GetValueOnAnyThread(), 1);
+	int32 Iterations = FMath::Max(CVarNeutronSaveTestFuzzIterations.GetValueOnAnyThread(), 1);
+	TestTrue(TEXT("Damaged saves are rejected or load intact in every format"), SaveManager->FuzzSaves(Size, Depth, Iterations, Seed));
+
+	return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
+
+#endif    // !UE_BUILD_SHIPPING
+
+/*----------------------------------------------------
+    Mapped saves
+----------------------------------------------------*/
+
+/** Check for JSON whitespace */
+template <typename CharType>
+static bool IsJsonWhitespace(CharType Char)
+{
+	return Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n';
+}
+
+/** Get a range of UTF-8 text as a string */
+static FString JsonRangeToString(const ANSICHAR* Data, int64 Begin, int64 End)
+{
+	FUTF8ToTCHAR Converted(Data + Begin, static_cast<int32>(End - Begin));
+	return FString(Converted.Length(), Converted.Get());
+}
+
+/** Get a range of text as a string */
+static FString JsonRangeToString(const TCHAR* Data, int64 Begin, int64 End)
+{
+	return FString(static_cast<int32>(End - Begin), Data + Begin);
+}
+
+/** Find the ranges of the values of the JSON object or array at a range of text, and the keys of object fields */
+template <typename CharType>
+static bool IndexJsonRange(const CharType* Data, int64 Begin, int64 End, TArray<TPair<int64, int64>>& Values, TArray<FString>* Keys)
+{
+	int64 Position = Begin;
+	while (Position < End && IsJsonWhitespace(Data[Position]))
+	{
+		Position++;
+	}
+	if (Position >= End || (Data[Position] != '{' && Data[Position] != '['))
+	{
+		return false;
+	}
+	bool IsObject = Data[Position] == '{';
+	Position++;
+
+	while (true)
+	{
+		while (Position < End && IsJsonWhitespace(Data[Position]))
+		{
+			Position++;
+		}
+		if (Position >= End)
+		{
+			return false;
+		}
+		else if (Data[Position] == '}' || Data[Position] == ']')
+		{
+			return true;
+		}
+
+		// Read the key of object fields
+		if (IsObject)
+		{
+			if (Data[Position] != '"')
+			{
+				return false;
+			}
+
+			int64 KeyBegin = ++Position;
+			while (Position < End && Data[Position] != '"')
+			{
+				Position += Data[Position] == '\\' ? 2 : 1;
+			}
+			if (Keys)
+			{
+				Keys->Add(JsonRangeToString(Data, KeyBegin, FMath::Min(Position, End)));
+			}
+
+			Position++;
+			while (Position < End && (IsJsonWhitespace(Data[Position]) || Data[Position] == ':'))
+			{
+				Position++;
+			}
+		}
+
+		// Find the end of the value, skipping over strings and nested containers
+		int64 ValueBegin = Position;
+		int32 Depth      = 0;
+		bool  InString   = false;
+		for (; Position < End; Position++)
+		{
+			CharType Char = Data[Position];
+			if (InString)
+			{
+				if (Char == '\\')
+				{
+					Position++;
+				}
+				else if (Char == '"')
+				{
+					InString = false;
+				}
+			}
+			else if (Char == '"')
+			{
+				InString = true;
+			}
+			else if (Char == '{' || Char == '[')
+			{
+				Depth++;
+			}
+			else if (Char == '}' || Char == ']')
+			{
+				if (Depth == 0)
+				{
+					break;
+				}
+				Depth--;
+			}
+			else if (Char == ',' && Depth == 0)
+			{
+				break;
+			}
+		}
+		if (Position >= End)
+		{
+			return false;
+		}
+
+		int64 ValueEnd = Position;
+		while (ValueEnd > ValueBegin && IsJsonWhitespace(Data[ValueEnd - 1]))
+		{
+			ValueEnd--;
+		}
+		Values.Add(TPair<int64, int64>(ValueBegin, ValueEnd));
+
+		if (Data[Position] == ',')
+		{
+			Position++;
+		}
+	}
+}
+
+FNeutronMappedSave::FNeutronMappedSave() : MappedData(nullptr)
+{}
+
+FNeutronMappedSave::~FNeutronMappedSave()
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FNeutronMappedSave::Open(const FString& Filename)
+{
+	int64 Begin = 0;
+	int64 End   = 0;
+
+	// Map the file when the platform supports it
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if (MappedRegion.IsValid())
+	{
+		const uint8* Data = MappedRegion->GetMappedPtr();
+		End               = MappedRegion->GetMappedSize();
+
+		// Only UTF-8 text can be used in place, skipping the byte order mark
+		if (End < 2 || Data[0] != 0xFF || Data[1] != 0xFE)
+		{
+			MappedData = Data;
+			if (End >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF)
+			{
+				Begin = 3;
+			}
+		}
+	}
+
+	// Otherwise load the text
+	if (MappedData == nullptr)
+	{
+		MappedRegion.Reset();
+		MappedFile.Reset();
+
+		if (!FFileHelper::LoadFileToString(LoadedText, *Filename))
+		{
+			return false;
+		}
+
+		Begin = 0;
+		End   = LoadedText.Len();
+	}
+
+	// Index the top-level fields
+	TArray<TPair<int64, int64>> Values;
+	TArray<FString>             Keys;
+	if (!IndexRange(TPair<int64, int64>(Begin, End), Values, &Keys))
+	{
+		NERR("FNeutronMappedSave::Open : failed to index '%s'", *Filename);
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Keys.Num(); Index++)
+	{
+		Fields.Add(Keys[Index], Values[Index]);
+	}
+
+	return true;
+}
+
+TArray<FString> FNeutronMappedSave::GetFieldNames() const
+{
+	TArray<FString> Names;
+	Fields.GenerateKeyArray(Names);
+
+	return Names;
+}
+
+TSharedPtr<FJsonValue> FNeutronMappedSave::GetField(const FString& Name) const
+{
+	const TPair<int64, int64>* Range = Fields.Find(Name);
+	if (Range)
+	{
+		return ParseRange(*Range);
+	}
+
+	return nullptr;
+}
+
+int32 FNeutronMappedSave::GetArrayFieldNum(const FString& Name)
+{
+	TArray<TPair<int64, int64>>* Elements = ArrayElements.Find(Name);
+
+	// Index the elements on first access
+	if (Elements == nullptr)
+	{
+		const TPair<int64, int64>* Range = Fields.Find(Name);
+		if (Range == nullptr)
+		{
+			return 0;
+		}
+
+		Elements = &ArrayElements.Add(Name);
+		if (!IndexRange(*Range, *Elements, nullptr))
+		{
+			Elements->Empty();
+		}
+	}
+
+	return Elements->Num();
+}
+
+TSharedPtr<FJsonValue> FNeutronMappedSave::GetArrayFieldElement(const FString& Name, int32 Index)
+{
+	if (Index >= 0 && Index < GetArrayFieldNum(Name))
+	{
+		return ParseRange(ArrayElements[Name][Index]);
+	}
+
+	return nullptr;
+}
+
+bool FNeutronMappedSave::ReadField(const UScriptStruct* Struct, void* SaveData, FName PropertyName) const
+{
+	NCHECK(Struct);
+	NCHECK(SaveData);
+
+	FProperty* Property = Struct->FindPropertyByName(PropertyName);
+	if (Property)
+	{
+		TSharedPtr<FJsonValue> Value = GetField(Property->GetName());
+		if (Value.IsValid())
+		{
+			return FJsonObjectConverter::JsonValueToUProperty(Value, Property, Property->ContainerPtrToValuePtr<void>(SaveData));
+		}
+	}
+
+	return false;
+}
+
+TSharedPtr<FJsonValue> FNeutronMappedSave::ParseRange(const TPair<int64, int64>& Range) const
+{
+	FString Text = MappedData ? JsonRangeToString(reinterpret_cast<const ANSICHAR*>(MappedData), Range.Key, Range.Value)
+	                          : JsonRangeToString(*LoadedText, Range.Key, Range.Value);
+
+	// Parse as a single-element array so that any value can be read
+	TArray<TSharedPtr<FJsonValue>> Values;
+	TSharedRef<TJsonReader<>>      Reader = TJsonReaderFactory<>::Create(TEXT("[") + Text + TEXT("]"));
+	if (FJsonSerializer::Deserialize(Reader, Values) && Values.Num() == 1)
+	{
+		return Values[0];
+	}
+
+	return nullptr;
+}
+
+bool FNeutronMappedSave::IndexRange(const TPair<int64, int64>& Range, TArray<TPair<int64, int64>>& Values, TArray<FString>* Keys) const
+{
+	if (MappedData)
+	{
+		return IndexJsonRange(reinterpret_cast<const ANSICHAR*>(MappedData), Range.Key, Range.Value, Values, Keys);
+	}
+	else
+	{
+		return IndexJsonRange(*LoadedText, Range.Key, Range.Value, Values, Keys);
+	}
+}
+
+TSharedPtr<FNeutronMappedSave> UNeutronSaveManager::OpenMappedSave(const FString SaveName)
+{
+	FString Filename = GetSaveGamePath(SaveName, false);
+
+	if (IFileManager::Get().FileSize(*Filename) > 0)
+	{
+		TSharedPtr<FNeutronMappedSave> MappedSave = MakeShared<FNeutronMappedSave>();
+		if (MappedSave->Open(Filename))
+		{
+			return MappedSave;
+		}
+	}
+
+	return nullptr;
+}
+
+/** Compare the time to the first field of an uncompressed JSON save between a full parse and a mapped save */
+static FAutoConsoleCommand NeutronBenchmarkMappedSaveCommand(TEXT("Neutron.BenchmarkMappedSave"),
+	TEXT("Compare the time to read a field of an uncompressed JSON save, parsed fully or mapped - takes a save name, and an optional "
+		 "field name defaulting to the last payload field"),
+	FConsoleCommandWithArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args)
+		{
+			if (Args.Num() < 1 || Args.Num() > 2)
+			{
+				NERR("Neutron.BenchmarkMappedSave : expected a save name and an optional field name");
+				return;
+			}
+
+			FString Filename  = UNeutronSaveManager::GetSaveGamePath(Args[0], false);
+			FString FieldName = Args.Num() > 1 ? Args[1] : FString();
+
+			// Pick the last payload field, which the mapping has to skip everything else to reach
+			FNeutronMappedSave MappedSave;
+			if (FieldName.IsEmpty() && MappedSave.Open(Filename))
+			{
+				for (const FString& Name : MappedSave.GetFieldNames())
+				{
+					if (Name != NeutronJsonSchemaVersionField && Name != NeutronJsonStructField && Name != NeutronJsonChecksumField)
+					{
+						FieldName = Name;
+					}
+				}
+			}
+
+			// Full parse
+			double                  StartTime = FPlatformTime::Seconds();
+			FString                 SaveString;
+			TSharedPtr<FJsonObject> FullData;
+			TSharedPtr<FJsonValue>  FullField;
+			if (FFileHelper::LoadFileToString(SaveString, *Filename))
+			{
+				TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(SaveString);
+				if (FJsonSerializer::Deserialize(Reader, FullData) && FullData.IsValid())
+				{
+					FullField = FullData->TryGetField(FieldName);
+				}
+			}
+			double FullParseTime = FPlatformTime::Seconds() - StartTime;
+
+			// Mapped save
+			StartTime = FPlatformTime::Seconds();
+			FNeutronMappedSave     TimedMappedSave;
+			TSharedPtr<FJsonValue> MappedField;
+			if (TimedMappedSave.Open(Filename))
+			{
+				MappedField = TimedMappedSave.GetField(FieldName);
+			}
+			double MappedTime = FPlatformTime::Seconds() - StartTime;
+
+			if (FullField.IsValid() && MappedField.IsValid())
+			{
+				NLOG("Neutron.BenchmarkMappedSave : '%s' field '%s' full parse %.2fms, mapped %.2fms", *Filename, *FieldName,
+					FullParseTime * 1000.0, MappedTime * 1000.0);
+			}
+			else
+			{
+				NERR("Neutron.BenchmarkMappedSave : failed to read field '%s' of '%s'", *FieldName, *Filename);
+			}
+		}));
+
+/*----------------------------------------------------
+    Helpers
+----------------------------------------------------*/
+
+FString UNeutronSaveManager::GetSaveGamePath(const FString SaveName, bool Compressed, bool Temporary)
+{
+	FString Path;
+
+	if (Compressed)
+	{
+		Path = FString::Printf(TEXT("%s/%s.sav"), *FPaths::ProjectSavedDir(), *SaveName);
+	}
+	else
+	{
+		Path = FString::Printf(TEXT("%s/%s.json"), *FPaths::ProjectSavedDir(), *SaveName);
+	}
+
+	if (Temporary)
+	{
+		Path += TEXT(".tmp");
+	}
+
+	return Path;
+}
+
+FString UNeutronSaveManager::GetSaveBackupPath(const FString SaveName, bool Compressed, int32 Index)
+{
+	return FString::Printf(TEXT("%s.%d.bak"), *GetSaveGamePath(SaveName, Compressed), Index);
+}
+
+FString UNeutronSaveManager::GetSaveJournalPath(const FString SaveName)
+{
+	return FString::Printf(TEXT("%s/%s.journal"), *FPaths::ProjectSavedDir(), *SaveName);
+}
+
+FString UNeutronSaveManager::GetSaveIndexPath(bool Temporary)
+{
+	return FString::Printf(TEXT("%s/SaveIndex.idx%s"), *FPaths::ProjectSavedDir(), Temporary ? TEXT(".tmp") : TEXT(""));
 }
 
 FString UNeutronSaveManager::JsonToString(const TSharedPtr<FJsonObject>& SaveData)
@@ -13,6 +13,211 @@ struct NEUTRON_API FNeutronSaveDataBase
 	GENERATED_BODY()
 };
 
+/** Save file formats */
+enum class ENeutronSaveFormat : uint8
+{
+	Json,
+	Binary
+};
+
+/** Save file compression codecs */
+enum class ENeutronSaveCodec : uint8
+{
+	None,
+	Zlib,
+	Oodle,
+	LZ4
+};
+
+// Asynchronous load completion delegate
+DECLARE_DELEGATE_OneParam(FNeutronAsyncLoadCallback, bool);
+
+/** Save migration step, upgrading the JSON tree or the binary payload of a save from a schema version to the next */
+struct FNeutronSaveMigration
+{
+	TFunction<bool(const TSharedRef<class FJsonObject>&)> Json;
+	TFunction<bool(TArray<uint8>&)>                       Binary;
+};
+
+/** Asynchronous save waiting to be written */
+struct FNeutronSaveRequest
+{
+	const UScriptStruct*             Struct;
+	TSharedPtr<FNeutronSaveDataBase> SaveDataOwner;
+	const void*                      SaveData;
+	bool                             Compress;
+	double                           QueueTime;
+};
+
+/** Asynchronous load waiting for the saves queued before it to the same slot */
+struct FNeutronLoadRequest
+{
+	const UScriptStruct*                      Struct;
+	TSharedPtr<FNeutronSaveDataBase>          SaveDataOwner;
+	void*                                     SaveData;
+	FNeutronAsyncLoadCallback                 Callback;
+	TWeakObjectPtr<class UNeutronSaveManager> SaveSystem;
+};
+
+/** Asynchronous saves and loads for a slot, with at most one save being written and one pending, and loads running after saves */
+struct FNeutronSaveSlotQueue
+{
+	FNeutronSaveSlotQueue() : Writing(false)
+	{}
+
+	TOptional<FNeutronSaveRequest> PendingRequest;
+	TArray<FNeutronLoadRequest>    PendingLoads;
+	bool                           Writing;
+};
+
+/** Asynchronous save statistics */
+struct FNeutronSaveQueueStats
+{
+	FNeutronSaveQueueStats() : QueueDepth(0), WrittenCount(0), CoalescedCount(0), LastWriteLatency(0), MaxWriteLatency(0)
+	{}
+
+	// Saves pending or being written
+	int32 QueueDepth;
+
+	// Saves written to disk
+	int32 WrittenCount;
+
+	// Saves replaced by a newer save to the same slot before being written
+	int32 CoalescedCount;
+
+	// Time from request to completion in seconds
+	double LastWriteLatency;
+	double MaxWriteLatency;
+};
+
+/** On-disk state of an incremental save, as last written in this session */
+struct FNeutronSaveJournalState
+{
+	FNeutronSaveJournalState() : Format(ENeutronSaveFormat::Json), BaseChecksum(0), BaseSize(0), JournalSize(0)
+	{}
+
+	TMap<FName, uint64> SectionHashes;
+	ENeutronSaveFormat  Format;
+	uint32              BaseChecksum;
+	int64               BaseSize;
+	int64               JournalSize;
+};
+
+/** Changed top-level property of a save, as read from its journal */
+struct FNeutronSaveJournalSection
+{
+	FString       Name;
+	FString       Type;
+	TArray<uint8> Data;
+};
+
+/** Journal of an incremental save, folded into its base save before migrating it */
+struct FNeutronSaveJournal
+{
+	FNeutronSaveJournal() : Version(0), Format(ENeutronSaveFormat::Json), SchemaVersion(0)
+	{}
+
+	// Sections in the order they were written, later ones replacing earlier ones
+	TArray<FNeutronSaveJournalSection> Sections;
+
+	// Engine versions the sections were serialized with
+	TArray<uint8> VersionData;
+
+	uint32             Version;
+	ENeutronSaveFormat Format;
+	uint32             SchemaVersion;
+};
+
+/** Save slot metadata kept in the save index, for listing saves without reading them */
+struct FNeutronSaveSlotInfo
+{
+	FNeutronSaveSlotInfo() : Size(0), SchemaVersion(0)
+	{}
+
+	friend FArchive& operator<<(FArchive& Ar, FNeutronSaveSlotInfo& Info)
+	{
+		Ar << Info.SlotName;
+		Ar << Info.Timestamp;
+		Ar << Info.Size;
+		Ar << Info.SchemaVersion;
+		Ar << Info.StructPath;
+		Ar << Info.Summary;
+		Ar << Info.Thumbnail;
+
+		return Ar;
+	}
+
+	// Slot name
+	FString SlotName;
+
+	// Time of the last save, in UTC
+	FDateTime Timestamp;
+
+	// Size on disk in bytes, including the journal
+	int64 Size;
+
+	// Schema version of the save data, zero for unversioned saves
+	int32 SchemaVersion;
+
+	// Path name of the game state structure the save holds, empty for saves written before it was recorded
+	FString StructPath;
+
+	// Game-defined fields such as play time or location
+	TMap<FString, FString> Summary;
+
+	// Optional encoded thumbnail image
+	TArray<uint8> Thumbnail;
+};
+
+/** Uncompressed JSON save mapped in memory, with fields only parsed when accessed - release it before saving to the same slot */
+class NEUTRON_API FNeutronMappedSave
+{
+public:
+
+	FNeutronMappedSave();
+	~FNeutronMappedSave();
+
+	/** Map a save file and index its top-level fields */
+	bool Open(const FString& Filename);
+
+	/** Get the names of the top-level fields */
+	TArray<FString> GetFieldNames() const;
+
+	/** Parse a single top-level field */
+	TSharedPtr<class FJsonValue> GetField(const FString& Name) const;
+
+	/** Get the number of elements in a top-level array field without parsing them */
+	int32 GetArrayFieldNum(const FString& Name);
+
+	/** Parse a single element of a top-level array field */
+	TSharedPtr<class FJsonValue> GetArrayFieldElement(const FString& Name, int32 Index);
+
+	/** Deserialize a single top-level field into the matching property of a game state structure */
+	bool ReadField(const UScriptStruct* Struct, void* SaveData, FName PropertyName) const;
+
+protected:
+
+	/** Parse the JSON value at a range of the save */
+	TSharedPtr<class FJsonValue> ParseRange(const TPair<int64, int64>& Range) const;
+
+	/** Index the values of the JSON object or array at a range of the save */
+	bool IndexRange(const TPair<int64, int64>& Range, TArray<TPair<int64, int64>>& Values, TArray<FString>* Keys) const;
+
+protected:
+
+	// Mapped UTF-8 data
+	TUniquePtr<class IMappedFileHandle> MappedFile;
+	TUniquePtr<class IMappedFileRegion> MappedRegion;
+	const uint8*                        MappedData;
+
+	// Text loaded instead of mapped, for UTF-16 saves
+	FString LoadedText;
+
+	// Character ranges of the top-level fields, and of the elements of array fields that were accessed
+	TMap<FString, TPair<int64, int64>>         Fields;
+	TMap<FString, TArray<TPair<int64, int64>>> ArrayElements;
+};
+
 /** Game interface to load and write saves */
 UCLASS(ClassGroup = (Neutron))
 class NEUTRON_API UNeutronSaveManager : public UObject
@@ -47,6 +252,12 @@ public:
 	/** Delete a game save */
 	bool DeleteGame(const FString SaveName);
 
+	/** List the existing saves from the save index, newest first */
+	TArray<FNeutronSaveSlotInfo> EnumerateSaves();
+
+	/** Set the summary fields and thumbnail to store in the save index with the next save to a slot */
+	void SetSaveSummary(const FString SaveName, const TMap<FString, FString>& Summary, const TArray<uint8>& Thumbnail = TArray<uint8>());
+
 	/** Check for currently loaded save data */
 	bool HasLoadedSaveData() const
 	{
@@ -104,15 +315,51 @@ public:
 		return (CurrentTime - TimeOfLastSave) / (1000.0 * 60.0);
 	}
 
-	/** Start an asynchronous process to save data */
+	/** Set the format to use for future saves, loading detects the format automatically */
+	void SetSaveFormat(ENeutronSaveFormat Format)
+	{
+		SaveFormat = Format;
+	}
+
+	/** Get the format used for saves */
+	ENeutronSaveFormat GetSaveFormat() const
+	{
+		return SaveFormat;
+	}
+
+	/** Set the codec to use for future compressed saves, loading reads it from the file header */
+	void SetSaveCodec(ENeutronSaveCodec Codec)
+	{
+		SaveCodec = Codec;
+	}
+
+	/** Get the codec used for compressed saves */
+	ENeutronSaveCodec GetSaveCodec() const
+	{
+		return SaveCodec;
+	}
+
+	/** Set how many previous generations of compressed saves to keep as backups */
+	void SetBackupCount(int32 Count)
+	{
+		BackupCount = FMath::Max(Count, 0);
+	}
+
+	/** Enable appending only the changed top-level sections of compressed saves to a journal */
+	void SetIncrementalSaves(bool Enabled)
+	{
+		IncrementalSaves = Enabled;
+	}
+
+	/** Start an asynchronous process to save data, replacing any save to the same slot that wasn't started yet */
 	template <typename SaveDataType>
 	void SaveGameAsync(const FString SaveName, TSharedPtr<SaveDataType> SaveData, bool Compress = true)
 	{
-		// Serialize
-		TSharedPtr<class FJsonObject> JsonData = FJsonObjectConverter::UStructToJsonObject<SaveDataType>(*SaveData);
+		// Copy the data so that serialization can run on the worker thread
+		TSharedPtr<SaveDataType> SaveDataCopy = MakeShared<SaveDataType>(*SaveData);
 
 		// Save
-		SaveGameAsync(SaveName, JsonData, Compress);
+		SaveGameAsync(SaveName, SaveDataType::StaticStruct(), SaveDataCopy, SaveDataCopy.Get(), Compress);
 
 		// Reset the save time
 		TimeOfLastSave = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64());
@@ -122,32 +369,93 @@ public:
 	template <typename SaveDataType>
 	void SaveGame(const FString SaveName, TSharedPtr<SaveDataType> SaveData, bool Compress = true)
 	{
-		// Serialize
-		TSharedPtr<class FJsonObject> JsonData = FJsonObjectConverter::UStructToJsonObject<SaveDataType>(*SaveData);
-
 		// Save
-		SaveGame(SaveName, JsonData, Compress);
+		SaveGame(SaveName, SaveDataType::StaticStruct(), SaveData.Get(), Compress);
 
 		// Reset the save time
 		TimeOfLastSave = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64());
 	}
 
+	/** Wait for all asynchronous saves to be written, and asynchronous loads to be read */
+	void FlushPendingSaves();
+
+	/** Get statistics on asynchronous saves */
+	FNeutronSaveQueueStats GetSaveQueueStats();
+
 	/** Load a game state structure synchronously from the filesystem */
 	template <typename SaveDataType>
 	TSharedPtr<SaveDataType> LoadGame(const FString SaveName)
 	{
 		CurrentSaveFileName = SaveName;
 
-		// Load
-		TSharedPtr<class FJsonObject> JsonData = LoadGameInternal(SaveName);
+		// Load and deserialize the data
+		TSharedPtr<SaveDataType> SaveData = MakeShared<SaveDataType>();
+		LoadGameInternal(SaveName, SaveDataType::StaticStruct(), SaveData.Get());
 
 		// Reset the save time
 		TimeOfLastSave = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64());
 
-		// Deserialize the data
-		CurrentSaveData = MakeShared<SaveDataType>();
-		FJsonObjectConverter::JsonObjectToUStruct<SaveDataType>(JsonData.ToSharedRef(), static_cast<SaveDataType*>(CurrentSaveData.Get()));
-		return StaticCastSharedPtr<SaveDataType>(CurrentSaveData);
+		CurrentSaveData = SaveData;
+		return SaveData;
+	}
+
+	/** Load a game state structure on a worker thread after the saves queued to the slot, the callback getting nullptr on failure */
+	template <typename SaveDataType>
+	void LoadGameAsync(const FString SaveName, TDelegate<void(TSharedPtr<SaveDataType>, bool)> Callback)
+	{
+		CurrentSaveFileName = SaveName;
+
+		TSharedPtr<SaveDataType> SaveData = MakeShared<SaveDataType>();
+		LoadGameAsync(SaveName, SaveDataType::StaticStruct(), SaveData, SaveData.Get(),
+			FNeutronAsyncLoadCallback::CreateWeakLambda(this,
+				[this, SaveData, Callback](bool Success)
+				{
+					// Keep the current data when the save couldn't be read
+					if (Success)
+					{
+						// Reset the save time
+						TimeOfLastSave = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64());
+
+						CurrentSaveData = SaveData;
+					}
+
+					Callback.ExecuteIfBound(Success ? SaveData : nullptr, Success);
+				}));
+	}
+
+	/** Open an uncompressed JSON save for lazy access to its fields, or return nullptr */
+	TSharedPtr<FNeutronMappedSave> OpenMappedSave(const FString SaveName);
+
+	/** Register the step upgrading saves of a structure from a schema version to the next, the last step setting the current version */
+	template <typename SaveDataType>
+	void RegisterSaveMigration(uint32 FromVersion, FNeutronSaveMigration Migration)
+	{
+		RegisterSaveMigration(SaveDataType::StaticStruct(), FromVersion, Migration);
+	}
+
+	/** Register the step upgrading saves of a structure from a schema version to the next, before any save is loaded */
+	void RegisterSaveMigration(const UScriptStruct* Struct, uint32 FromVersion, FNeutronSaveMigration Migration);
+
+	/** Get the current schema version of a save structure */
+	uint32 GetSchemaVersion(const UScriptStruct* Struct) const;
+
+	/** Load and rewrite all saves of a structure older than its current schema version in parallel, returning the upgraded count */
+	int32 UpgradeAllSaves(const UScriptStruct* Struct);
+
+#if !UE_BUILD_SHIPPING
+
+	/** Time repeated saves and loads of random data of a size and depth in every format, logging throughput, latency and memory */
+	bool BenchmarkSaves(int64 Size, int32 Depth, int32 Iterations, int32 Seed);
+
+	/** Load truncated and corrupted copies of a random save in every format, failing if any loads with different data */
+	bool FuzzSaves(int64 Size, int32 Depth, int32 Iterations, int32 Seed);
+
+#endif
+
+	/** Check for asynchronous loads that haven't completed yet, for use in FNeutronAsyncCondition */
+	bool IsLoadingGame() const
+	{
+		return PendingLoadCount > 0;
 	}
 
 	/*----------------------------------------------------
@@ -156,14 +464,89 @@ public:
 
 protected:
 
-	/** Start an asynchronous process to save data */
-	void SaveGameAsync(const FString SaveName, TSharedPtr<class FJsonObject> JsonData, bool Compress = true);
+	/** Queue an asynchronous save, SaveDataOwner keeping SaveData alive until the save is done */
+	void SaveGameAsync(const FString SaveName, const UScriptStruct* Struct, TSharedPtr<FNeutronSaveDataBase> SaveDataOwner,
+		const void* SaveData, bool Compress = true);
 
 	/** Serialize and save a game state structure synchronously to the filesystem with optional compression */
-	bool SaveGame(const FString SaveName, TSharedPtr<class FJsonObject> JsonData, bool Compress = true);
+	bool SaveGame(const FString SaveName, const UScriptStruct* Struct, const void* SaveData, bool Compress = true);
+
+	/** Serialize and save a game state structure synchronously to the filesystem with a specific format and codec */
+	bool SaveGame(
+		const FString SaveName, const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, ENeutronSaveCodec Codec);
+
+	/** Write queued saves and run queued loads for a slot until none is left, on a worker thread */
+	void ProcessSaveQueue(const FString SaveName);
+
+	/** Queue an asynchronous load after the saves to the same slot, SaveDataOwner keeping SaveData alive until the load is done */
+	void LoadGameAsync(const FString SaveName, const UScriptStruct* Struct, TSharedPtr<FNeutronSaveDataBase> SaveDataOwner, void* SaveData,
+		FNeutronAsyncLoadCallback Callback);
+
+	/** Implementation of game loading, optionally returning the format and codec of the file that was read */
+	bool LoadGameInternal(const FString SaveName, const UScriptStruct* Struct, void* SaveData, ENeutronSaveFormat* LoadedFormat = nullptr,
+		ENeutronSaveCodec* LoadedCodec = nullptr);
+
+	/** Get the existing files a save can be loaded from in order of preference, each with whether it is a compressed save file */
+	TArray<TPair<FString, bool>> GetSaveCandidates(const FString SaveName) const;
+
+	/** Serialize a game state structure into an archive with the requested format */
+	static bool SerializeSaveData(const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, FArchive& Archive);
+
+	/** Deserialize a raw payload with the requested format into a game state structure, folding in its journal, then upgrading it */
+	bool DeserializeSaveData(const UScriptStruct* Struct, void* SaveData, ENeutronSaveFormat Format, TArray<uint8>& Payload,
+		uint32 SchemaVersion, const FNeutronSaveJournal* Journal = nullptr) const;
+
+	/** Run the migration steps upgrading the JSON tree, or the binary payload if there is no tree, to the current schema version */
+	bool MigrateSaveData(
+		const UScriptStruct* Struct, uint32 SchemaVersion, const TSharedPtr<class FJsonObject>& JsonData, TArray<uint8>& Payload) const;
 
-	/** Implementation of game loading */
-	TSharedPtr<FJsonObject> LoadGameInternal(const FString SaveName);
+	/** Rotate backups and replace a save with its fully written temporary file, which loading falls back to if this is interrupted */
+	bool CommitSaveFile(const FString SaveName, bool Compressed);
+
+	/** Write an uncompressed JSON save, with its schema version, structure and the checksum of the preceding text as extra fields */
+	static bool WriteSaveTextFile(const FString& Filename, const UScriptStruct* Struct, const void* SaveData, uint32 SchemaVersion);
+
+	/** Read an uncompressed JSON save into its UTF-8 payload, failing on a bad checksum */
+	static bool ReadSaveTextFile(const FString& Filename, TArray<uint8>& Payload);
+
+	/** Write a save file header, payload compressed block by block as it is serialized, and checksum footer */
+	static bool WriteSaveFile(const FString& Filename, const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format,
+		ENeutronSaveCodec Codec, uint32 SchemaVersion);
+
+	/** Read a save file into its uncompressed payload, failing on a bad checksum */
+	static bool ReadSaveFile(
+		const FString& Filename, ENeutronSaveFormat& Format, ENeutronSaveCodec& Codec, TArray<uint8>& Payload, uint32& SchemaVersion);
+
+	/** Read the checksum footer of a save file */
+	static bool ReadSaveChecksum(const FString& Filename, uint32& Checksum);
+
+	/** Append the changed sections of a save to its journal, returning false when a full save is required */
+	bool WriteSaveJournal(const FString SaveName, const UScriptStruct* Struct, const void* SaveData);
+
+	/** Start a new journal after a full save written with a format */
+	void ResetSaveJournal(const FString SaveName, const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format);
+
+	/** Read the journal of a save, if it was written on top of the current save file */
+	bool ReadSaveJournal(const FString SaveName, FNeutronSaveJournal& Journal) const;
+
+	/** Fold journal sections into the JSON tree, or the binary payload if there is no tree, of their base save */
+	static bool FoldSaveJournal(const FNeutronSaveJournal& Journal, const TSharedPtr<class FJsonObject>& JsonData, TArray<uint8>& Payload);
+
+	/** Read the save index from disk, or rebuild it from the existing saves, if it isn't loaded yet */
+	void LoadSaveIndex();
+
+	/** Write the save index to disk */
+	void WriteSaveIndex();
+
+	/** Update the save index entry of a save that was just written */
+	void UpdateSaveIndex(const FString SaveName, bool Compressed, const UScriptStruct* Struct, uint32 SchemaVersion);
+
+	/** Serialize each top-level property of a game state structure as a journal section, in the form a full save holds it */
+	static bool SerializeSaveSections(
+		const UScriptStruct* Struct, const void* SaveData, ENeutronSaveFormat Format, TArray<TPair<FName, TArray<uint8>>>& Sections);
+
+	/** Deserialize an untagged binary section from a journal written before sections were tagged into a top-level property */
+	static bool DeserializeSaveSection(const FProperty* Property, void* SaveData, FArchive& Archive);
 
 public:
 
@@ -172,7 +555,16 @@ public:
 	----------------------------------------------------*/
 
 	/** Get the path to save game file for the given name */
-	static FString GetSaveGamePath(const FString SaveName, bool Compressed);
+	static FString GetSaveGamePath(const FString SaveName, bool Compressed, bool Temporary = false);
+
+	/** Get the path to a backup of the save game file for the given name, starting at 1 for the newest */
+	static FString GetSaveBackupPath(const FString SaveName, bool Compressed, int32 Index);
+
+	/** Get the path to the incremental save journal for the given name */
+	static FString GetSaveJournalPath(const FString SaveName);
+
+	/** Get the path to the save index */
+	static FString GetSaveIndexPath(bool Temporary = false);
 
 	/** Serialize a save data object into a string */
 	static FString JsonToString(const TSharedPtr<class FJsonObject>& SaveData);
@@ -194,13 +586,31 @@ protected:
 
 	// Critical sections
 	FCriticalSection SaveLock;
-	FCriticalSection SaveListLock;
+	FCriticalSection SaveQueueLock;
+	FCriticalSection SaveIndexLock;
 
 	// Save data
 	TSharedPtr<FNeutronSaveDataBase> CurrentSaveData;
 	FString                          CurrentSaveFileName;
 	double                           TimeOfLastSave;
-
-	// Prepared game save data
-	TArray<TSharedPtr<class FJsonObject>> SaveList;
+	int32                            PendingLoadCount;
+	ENeutronSaveFormat               SaveFormat;
+	ENeutronSaveCodec                SaveCodec;
+	int32                            BackupCount;
+	bool                             IncrementalSaves;
+
+	// Incremental save state
+	TMap<FString, FNeutronSaveJournalState> JournalStates;
+
+	// Save migration steps, indexed by the schema version they upgrade from
+	TMap<const UScriptStruct*, TArray<FNeutronSaveMigration>> SaveMigrations;
+
+	// Asynchronous save queues
+	TMap<FString, FNeutronSaveSlotQueue> SaveQueues;
+	FNeutronSaveQueueStats               SaveQueueStats;
+
+	// Save index
+	TMap<FString, FNeutronSaveSlotInfo> SaveIndex;
+	TMap<FString, FNeutronSaveSlotInfo> PendingSaveSummaries;
+	bool                                SaveIndexLoaded;
 };
@@ -24,6 +24,7 @@ void SNeutronButton::Construct(const FArguments& InArgs)
 	ThemeName             = InArgs._Theme;
 	SizeName              = InArgs._Size;
 	Icon                  = InArgs._Icon;
+	PrefetchAssets        = InArgs._PrefetchAssets;
 	ButtonEnabled         = InArgs._Enabled;
 	ButtonFocusable       = (InArgs._Action.Get() != NAME_None && !InArgs._ActionFocusable) ? false : InArgs._Focusable;
 	ButtonActionFocusable = InArgs._ActionFocusable;
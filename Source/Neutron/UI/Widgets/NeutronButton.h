@@ -106,6 +106,7 @@ class NEUTRON_API SNeutronButton : public SButton
 	SLATE_ATTRIBUTE(FText, HelpText)
 	SLATE_ATTRIBUTE(FName, Action)
 	SLATE_ATTRIBUTE(const FSlateBrush*, Icon)
+	SLATE_ATTRIBUTE(TArray<FSoftObjectPath>, PrefetchAssets)
 	SLATE_ARGUMENT(FName, Theme)
 	SLATE_ARGUMENT(FName, Size)
 	SLATE_ARGUMENT(FNeutronButtonUserSizeCallback, UserSizeCallback)
@@ -217,6 +218,12 @@ public:
 	/** Get the action binding for closing this menu */
 	FName GetActionName() const;
 
+	/** Get the assets that clicking this button will need, to prefetch them when focused */
+	TArray<FSoftObjectPath> GetPrefetchAssets() const
+	{
+		return PrefetchAssets.Get(TArray<FSoftObjectPath>());
+	}
+
 	/*----------------------------------------------------
 	    Callbacks
 	----------------------------------------------------*/
@@ -267,6 +274,7 @@ protected:
 	TAttribute<FText>                     HelpText;
 	TAttribute<FName>                     Action;
 	TAttribute<const struct FSlateBrush*> Icon;
+	TAttribute<TArray<FSoftObjectPath>>   PrefetchAssets;
 	FName                                 ThemeName;
 	FName                                 SizeName;
 	float                                 BorderRotation;
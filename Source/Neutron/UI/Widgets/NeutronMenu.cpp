@@ -5,6 +5,7 @@
 #include "NeutronNavigationPanel.h"
 #include "NeutronModalPanel.h"
 
+#include "Neutron/System/NeutronAssetManager.h"
 #include "Neutron/System/NeutronMenuManager.h"
 #include "Neutron/Neutron.h"
 
@@ -439,6 +440,13 @@ void SNeutronMenu::SetFocusedButton(TSharedPtr<SNeutronButton> FocusButton, bool
 
 		FocusButton->SetFocused(true);
 
+		// Start loading what the button leads to, in case it gets clicked
+		UNeutronAssetManager* AssetManager = UNeutronAssetManager::Get();
+		if (AssetManager)
+		{
+			AssetManager->PrefetchAssets(FocusButton->GetPrefetchAssets());
+		}
+
 		if (FromNavigation && CurrentNavigationPanel)
 		{
 			CurrentNavigationPanel->OnFocusChanged(FocusButton);
@@ -94,6 +94,12 @@ public:
 	virtual void OnFocusChanged(TSharedPtr<class SNeutronButton> FocusButton)
 	{}
 
+	/** Get the assets this panel will need once shown, to prefetch them */
+	virtual TArray<FSoftObjectPath> GetPrefetchAssets() const
+	{
+		return TArray<FSoftObjectPath>();
+	}
+
 	/** Check whether this panel is modal */
 	virtual bool IsModal() const
 	{
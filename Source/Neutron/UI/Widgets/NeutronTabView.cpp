@@ -3,6 +3,7 @@
 #include "NeutronTabView.h"
 #include "NeutronMenu.h"
 
+#include "Neutron/System/NeutronAssetManager.h"
 #include "Neutron/UI/NeutronUI.h"
 #include "Neutron/Neutron.h"
 
@@ -109,7 +110,7 @@ float SNeutronTabPanel::GetBlurStrength() const
     Construct
 ----------------------------------------------------*/
 
-SNeutronTabView::SNeutronTabView() : DesiredTabIndex(0), CurrentTabIndex(0), CurrentBlurAlpha(0)
+SNeutronTabView::SNeutronTabView() : DesiredTabIndex(0), CurrentTabIndex(0), PrefetchedTabIndex(INDEX_NONE), CurrentBlurAlpha(0)
 {}
 
 void SNeutronTabView::Construct(const FArguments& InArgs)
@@ -319,12 +320,25 @@ void SNeutronTabView::Tick(const FGeometry& AllottedGeometry, const double Curre
 		}
 	}
 
+	// Prefetch the neighbors of the new tab while the current one fades out
+	if (PrefetchedTabIndex != DesiredTabIndex)
+	{
+		PrefetchAdjacentTabs();
+		PrefetchedTabIndex = DesiredTabIndex;
+	}
+
 	// Process widget change
 	if (CurrentTabIndex != DesiredTabIndex)
 	{
 		if (GetCurrentTabContent()->IsHidden())
 		{
 			CurrentTabIndex = DesiredTabIndex;
+
+			UNeutronAssetManager* AssetManager = UNeutronAssetManager::Get();
+			if (AssetManager)
+			{
+				AssetManager->RecordPrefetchedPanel(GetCurrentTabContent()->GetPrefetchAssets());
+			}
 		}
 	}
 
@@ -394,6 +408,33 @@ TSharedRef<SNeutronTabPanel> SNeutronTabView::GetCurrentTabContent() const
 	return SharedThis(Panels[CurrentTabIndex]);
 }
 
+void SNeutronTabView::PrefetchAdjacentTabs()
+{
+	UNeutronAssetManager* AssetManager = UNeutronAssetManager::Get();
+	if (AssetManager == nullptr)
+	{
+		return;
+	}
+
+	for (int32 Index = DesiredTabIndex - 1; Index >= 0; Index--)
+	{
+		if (IsTabVisible(Index))
+		{
+			AssetManager->PrefetchAssets(Panels[Index]->GetPrefetchAssets());
+			break;
+		}
+	}
+
+	for (int32 Index = DesiredTabIndex + 1; Index < Panels.Num(); Index++)
+	{
+		if (IsTabVisible(Index))
+		{
+			AssetManager->PrefetchAssets(Panels[Index]->GetPrefetchAssets());
+			break;
+		}
+	}
+}
+
 /*----------------------------------------------------
     Callbacks
 ----------------------------------------------------*/
@@ -165,6 +165,9 @@ public:
 	/** Get the current widget content root */
 	TSharedRef<SNeutronTabPanel> GetCurrentTabContent() const;
 
+	/** Prefetch the assets needed by the visible tabs next to the desired one */
+	void PrefetchAdjacentTabs();
+
 	/*----------------------------------------------------
 	    Callbacks
 	----------------------------------------------------*/
@@ -216,6 +219,7 @@ protected:
 	// Data
 	int32 DesiredTabIndex;
 	int32 CurrentTabIndex;
+	int32 PrefetchedTabIndex;
 	float CurrentBlurAlpha;
 
 	// Widgets